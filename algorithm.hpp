@@ -5,6 +5,7 @@
 #define TVD_ALGORITHM_HPP
 
 #include <algorithm>
+#include <type_traits>
 
 namespace tvd {
 // insert vector to matrix if
@@ -30,7 +31,7 @@ template<
     }
 // min value in matrix column
 template<typename _MatrixTy>
-    auto min( _MatrixTy const& m, size_t j_pos ) -> decltype( *m.begin() )
+    auto min( _MatrixTy const& m, size_t j_pos ) -> std::decay_t<decltype( *m.begin() )>
     {
       if( m.empty() ) {
           throw TVD_EXCEPTION("<tvd::min> : <matrix> is empty");
@@ -51,7 +52,7 @@ template<typename _MatrixTy>
     }
 // max value in matrix column
 template<typename _MatrixTy>
-    auto max( _MatrixTy const& m, size_t j_pos ) -> decltype( *m.begin() )
+    auto max( _MatrixTy const& m, size_t j_pos ) -> std::decay_t<decltype( *m.begin() )>
     {
       if( m.empty() ) {
           throw TVD_EXCEPTION("<tvd::max> : <matrix> is empty");
@@ -62,8 +63,8 @@ template<typename _MatrixTy>
       }
       auto first = m.cbegin();
       auto last = m.cend();
-      auto max = (*first);
       first += j_pos;
+      auto max = (*first);
       for(auto & fst(first); fst < last; fst += size)
       {
           if( max < (*fst) ) max = (*fst);
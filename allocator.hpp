@@ -0,0 +1,142 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the storage allocators
+#pragma once
+#ifndef TVD_ALLOCATOR_HPP
+#define TVD_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+#if defined(__linux__)
+# include <sys/mman.h>
+#endif
+
+namespace tvd {
+// aligns every block to <_Align> bytes, 64 covers a cache line and an avx-512 register
+template<
+    typename _Ty,
+    size_t _Align = 64>
+    class aligned_allocator
+    {
+      static_assert(
+        _Align >= alignof(_Ty) && ( _Align & ( _Align - 1 ) ) == 0,
+        "< tvd::aligned_allocator<_Ty, size_t> > : <_Align> must be a power of two not less than alignof(_Ty)"
+      );
+public :
+      using value_type = _Ty;
+      static constexpr size_t alignment = _Align;
+
+  template<typename Ty>
+      struct rebind { using other = aligned_allocator<Ty, _Align>; };
+
+      aligned_allocator() noexcept = default;
+
+  template<typename Ty>
+      aligned_allocator( aligned_allocator<Ty, _Align> const& ) noexcept
+      {
+      }
+
+      _Ty* allocate( size_t n )
+      {
+        if( n > std::numeric_limits<size_t>::max()/sizeof(_Ty) ) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<_Ty*>( ::operator new( n*sizeof(_Ty), std::align_val_t( _Align ) ) );
+      }
+
+      void deallocate( _Ty *p, size_t ) noexcept {
+        ::operator delete( p, std::align_val_t( _Align ) );
+      }
+
+  template<typename Ty>
+      bool operator == ( aligned_allocator<Ty, _Align> const& ) const noexcept {
+        return true;
+      }
+
+  template<typename Ty>
+      bool operator != ( aligned_allocator<Ty, _Align> const& ) const noexcept {
+        return false;
+      }
+    };
+// backs blocks of at least <threshold> bytes with 2 MiB pages : explicit huge pages when the system has
+// them reserved, transparent huge pages otherwise; smaller blocks are served as aligned_allocator does
+template<typename _Ty>
+    class huge_page_allocator
+    {
+public :
+      using value_type = _Ty;
+      static constexpr size_t page_size = size_t(2) << 20;
+      static constexpr size_t threshold = page_size/2;
+
+  template<typename Ty>
+      struct rebind { using other = huge_page_allocator<Ty>; };
+
+      huge_page_allocator() noexcept = default;
+
+  template<typename Ty>
+      huge_page_allocator( huge_page_allocator<Ty> const& ) noexcept
+      {
+      }
+
+      _Ty* allocate( size_t n )
+      {
+        if( n > std::numeric_limits<size_t>::max()/sizeof(_Ty) - page_size ) {
+            throw std::bad_array_new_length();
+        }
+        const size_t bytes = n*sizeof(_Ty);
+        if( bytes < threshold ) {
+            return static_cast<_Ty*>( ::operator new( bytes, std::align_val_t( 64 ) ) );
+        }
+        const size_t size = round_up( bytes );
+#if defined(__linux__)
+        void *p = MAP_FAILED;
+# ifdef MAP_HUGETLB
+        p = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+# endif
+        if( p == MAP_FAILED ) {
+            p = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+            if( p == MAP_FAILED ) {
+                throw std::bad_alloc();
+            }
+# ifdef MADV_HUGEPAGE
+            madvise( p, size, MADV_HUGEPAGE );
+# endif
+        }
+        return static_cast<_Ty*>( p );
+#else
+        return static_cast<_Ty*>( ::operator new( size, std::align_val_t( page_size ) ) );
+#endif
+      }
+
+      void deallocate( _Ty *p, size_t n ) noexcept
+      {
+        const size_t bytes = n*sizeof(_Ty);
+        if( bytes < threshold ) {
+            ::operator delete( p, std::align_val_t( 64 ) );
+            return;
+        }
+#if defined(__linux__)
+        munmap( p, round_up( bytes ) );
+#else
+        ::operator delete( p, std::align_val_t( page_size ) );
+#endif
+      }
+
+  template<typename Ty>
+      bool operator == ( huge_page_allocator<Ty> const& ) const noexcept {
+        return true;
+      }
+
+  template<typename Ty>
+      bool operator != ( huge_page_allocator<Ty> const& ) const noexcept {
+        return false;
+      }
+private :
+
+      static size_t round_up( size_t bytes ) noexcept {
+        return ( bytes + page_size - 1 )/page_size*page_size;
+      }
+    };
+} // tvd
+#endif
@@ -4,6 +4,7 @@
 #define TVD_BASE_MIXING_TEMPLATES_HPP
 
 #include "exception.hpp"
+#include "expression.hpp"
 
 namespace tvd {
 
@@ -14,13 +15,25 @@ template<class _ElemContainerTy>
     struct access
     {
       using container_t = typename _ElemContainerTy::container_t;
+      using allocator_t = typename _ElemContainerTy::allocator_t;
 
   template<class _DerivedTy>
-      static container_t& get_container( _DerivedTy *impl ) {
+      static constexpr container_t& get_container( _DerivedTy *impl ) {
         return impl->container_;
       }
+
+  template<class _DerivedTy>
+      static constexpr container_t const& get_container( _DerivedTy const* impl ) {
+        return impl->container_;
+      }
+
+  template<class _DerivedTy>
+      static allocator_t get_allocator( _DerivedTy const* impl ) {
+        return impl->container_.get_allocator();
+      }
     };
-// mixing for container class
+// mixing for container class, every mixin reaches the derived class by a static cast :
+// no virtual functions and no stored pointers, so the mixins add nothing to the object size
 template<
     class _DerivedTy,
     class _ElemContainerTy>
@@ -30,28 +43,30 @@ public :
       using derived_t        = _DerivedTy;
       using iterator_t       = typename _ElemContainerTy::container_t::iterator;
       using const_iterator_t = typename _ElemContainerTy::container_t::const_iterator;
-private :
-      derived_t *derived_;
-public :
-      add_base_iterators()
-        : derived_( static_cast<derived_t*>( this ) )
-      {
+
+      constexpr iterator_t begin() {
+        return access<_ElemContainerTy>::get_container( derived() ).begin();
+      }
+
+      constexpr iterator_t end() {
+        return access<_ElemContainerTy>::get_container( derived() ).end();
       }
-    
-      iterator_t begin() {
-        return access<_ElemContainerTy>::get_container( derived_ ).begin();
+
+      constexpr const_iterator_t begin() const {
+        return access<_ElemContainerTy>::get_container( derived() ).begin();
       }
 
-      iterator_t end() {
-        return access<_ElemContainerTy>::get_container( derived_ ).end();
+      constexpr const_iterator_t end() const {
+        return access<_ElemContainerTy>::get_container( derived() ).end();
       }
+private :
 
-      const_iterator_t begin() const {
-        return access<_ElemContainerTy>::get_container( derived_ ).begin();
+      constexpr derived_t* derived() {
+        return static_cast<derived_t*>( this );
       }
 
-      const_iterator_t end() const {
-        return access<_ElemContainerTy>::get_container( derived_ ).end();
+      constexpr derived_t const* derived() const {
+        return static_cast<derived_t const*>( this );
       }
     };
 
@@ -63,20 +78,13 @@ template<
 public :
       using derived_t        = _DerivedTy;
       using const_iterator_t = typename _ElemContainerTy::container_t::const_iterator;
-private :
-      derived_t *derived_;
-public :
-      add_const_iterators()
-        : derived_( static_cast<derived_t*>( this ) )
-      {
-      }
 
-      const_iterator_t cbegin() const {
-        return access<_ElemContainerTy>::get_container( derived_ ).cbegin();
+      constexpr const_iterator_t cbegin() const {
+        return access<_ElemContainerTy>::get_container( static_cast<derived_t const*>( this ) ).cbegin();
       }
 
-      const_iterator_t cend() const {
-        return access<_ElemContainerTy>::get_container( derived_ ).cend();
+      constexpr const_iterator_t cend() const {
+        return access<_ElemContainerTy>::get_container( static_cast<derived_t const*>( this ) ).cend();
       }
     };
 
@@ -93,10 +101,9 @@ template<
     class _AnyTy = _DerivedTy>
     struct add_non_equalable
     {
-      virtual bool operator == (_AnyTy const&) = 0;
-
-      bool operator != ( _AnyTy const& other ) {
-        return !( *this == other );
+      // <_DerivedTy> defines operator == ( _AnyTy const& ) const
+      friend bool operator != ( _DerivedTy const& l, _AnyTy const& r ) {
+        return !( l == r );
       }
     };
 
@@ -105,12 +112,10 @@ template<
     class _AnyTy = _DerivedTy>
     struct add_sum
     {
-      virtual _DerivedTy& operator += (_AnyTy const&) = 0;
-
-      _DerivedTy operator + ( _AnyTy const & other ) const
-      {
-        auto cpy = static_cast<const _DerivedTy&>( *this );
-        return cpy += other;
+      // <_DerivedTy> defines operator += ( _AnyTy const& ), the sum is a new container built in one pass;
+      // lazy( l ) + r keeps it an expression, see expression.hpp
+      friend auto operator + ( _DerivedTy const& l, _AnyTy const & r ) {
+        return expression_result_t<_DerivedTy>( make_expression<expression_add>( l, r ) );
       }
     };
 
@@ -119,12 +124,9 @@ template<
     class _AnyTy = _DerivedTy>
     struct add_difference
     {
-      virtual _DerivedTy& operator -= (_AnyTy const&) = 0;
-
-      _DerivedTy operator - ( _AnyTy const & other ) const
-      {
-        auto cpy = static_cast<const _DerivedTy&>( *this );
-        return cpy -= other;
+      // <_DerivedTy> defines operator -= ( _AnyTy const& ), the difference is a new container built in one pass
+      friend auto operator - ( _DerivedTy const& l, _AnyTy const & r ) {
+        return expression_result_t<_DerivedTy>( make_expression<expression_sub>( l, r ) );
       }
     };
 
@@ -134,12 +136,9 @@ template<
     class _ReturnTy = _DerivedTy>
     struct add_multiplying_by_value
     {
-      virtual _DerivedTy& operator *= (typename _ElemTraitsTy::type_t const&) = 0;
-
-      _ReturnTy operator * ( typename _ElemTraitsTy::type_t const & value )
-      {
-        _ReturnTy cpy = static_cast<_DerivedTy&>( *this );
-        return cpy *= value;
+      // <_DerivedTy> defines operator *= ( type_t const& ), the product is a new <_ReturnTy> built in one pass
+      friend auto operator * ( _DerivedTy const& d, typename _ElemTraitsTy::type_t const & value ) {
+        return _ReturnTy( make_scalar_expression<expression_mul>( d, value ) );
       }
     };
 
@@ -156,16 +155,15 @@ template<
         if(value <= 0) {
             throw TVD_EXCEPTION( "bad operation : value = 0" );
         }
-        return *this *= (1.0/value);
+        return static_cast<_DerivedTy&>( *this ) *= (1.0/value);
       }
 
-      _ReturnTy operator / ( typename _ElemTraitsTy::type_t const & value ) const
+      friend auto operator / ( _DerivedTy const& d, typename _ElemTraitsTy::type_t const & value )
       {
         if(value <= 0) {
             throw TVD_EXCEPTION( "bad operation : value = 0" );
         }
-        _ReturnTy cpy = static_cast<const _DerivedTy&>( *this );
-        return cpy *= ( 1.0/value );
+        return _ReturnTy( make_scalar_expression<expression_mul>( d, typename _ElemTraitsTy::type_t( 1.0/value ) ) );
       }
     };
 }
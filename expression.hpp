@@ -0,0 +1,333 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the lazy element-wise expressions
+#pragma once
+#ifndef TVD_EXPRESSION_HPP
+#define TVD_EXPRESSION_HPP
+
+#include "tvd/exception.hpp"
+#include "tvd/type_traits.hpp"
+
+#include <cstddef>
+#include <iterator>
+
+namespace tvd {
+// operand description, specialized next to every container :
+//   result_t - container an expression over this operand materializes into
+//   type_t   - element type
+//   extent() - number of elements, eval() - element by flat index
+//   by_value - optional, true for the views that an expression copies instead of referencing
+template<class _Ty>
+    struct expression_traits;
+// base of every expression node
+struct expression_base { };
+
+template<class _Ty>
+    inline constexpr bool is_expression_v = std::is_base_of_v<expression_base, _Ty>;
+
+template<class _Ty, class = void>
+    struct is_expression_operand : std::false_type { };
+
+template<class _Ty>
+    struct is_expression_operand<_Ty, std::void_t<typename expression_traits<_Ty>::result_t> > : std::true_type { };
+
+template<class _Ty>
+    inline constexpr bool is_expression_operand_v = is_expression_v<_Ty> || is_expression_operand<_Ty>::value;
+
+template<class _Ty, class = void>
+    struct is_expression_by_value : std::false_type { };
+
+template<class _Ty>
+    struct is_expression_by_value<_Ty, std::enable_if_t<expression_traits<_Ty>::by_value> > : std::true_type { };
+
+template<
+    typename _ExprTy,
+    typename _ResultTy>
+    using is_expression_of_t = std::enable_if_t<
+      is_expression_v<_ExprTy> && std::is_same_v<typename _ExprTy::result_t, _ResultTy>,
+      bool
+    >;
+// random access over the elements of an expression, lets containers build in one pass
+template<class _ExprTy>
+    class expression_iterator
+    {
+      _ExprTy const* expr_;
+      std::ptrdiff_t i_;
+public :
+      using iterator_category = std::random_access_iterator_tag;
+      using value_type        = typename _ExprTy::type_t;
+      using difference_type   = std::ptrdiff_t;
+      using pointer           = const value_type*;
+      using reference         = value_type;
+
+      expression_iterator( _ExprTy const& expr, std::ptrdiff_t i )
+        : expr_( &expr )
+        , i_( i )
+      {
+      }
+
+      reference operator * () const {
+        return expr_->eval( i_ );
+      }
+
+      reference operator [] ( difference_type n ) const {
+        return expr_->eval( i_ + n );
+      }
+
+      expression_iterator & operator ++ () { ++i_; return *this; }
+      expression_iterator & operator -- () { --i_; return *this; }
+      expression_iterator   operator ++ ( int ) { auto it = *this; ++i_; return it; }
+      expression_iterator   operator -- ( int ) { auto it = *this; --i_; return it; }
+      expression_iterator & operator += ( difference_type n ) { i_ += n; return *this; }
+      expression_iterator & operator -= ( difference_type n ) { i_ -= n; return *this; }
+      expression_iterator   operator +  ( difference_type n ) const { return { *expr_, i_ + n }; }
+      expression_iterator   operator -  ( difference_type n ) const { return { *expr_, i_ - n }; }
+      difference_type       operator -  ( expression_iterator const& other ) const { return i_ - other.i_; }
+
+      bool operator == ( expression_iterator const& other ) const { return i_ == other.i_; }
+      bool operator != ( expression_iterator const& other ) const { return i_ != other.i_; }
+      bool operator <  ( expression_iterator const& other ) const { return i_ <  other.i_; }
+      bool operator >  ( expression_iterator const& other ) const { return i_ >  other.i_; }
+      bool operator <= ( expression_iterator const& other ) const { return i_ <= other.i_; }
+      bool operator >= ( expression_iterator const& other ) const { return i_ >= other.i_; }
+    };
+// common part of the nodes
+template<
+    class _DerivedTy,
+    class _ResultTy>
+    struct expression_node : expression_base
+    {
+      using result_t = _ResultTy;
+      using type_t   = typename expression_traits<_ResultTy>::type_t;
+
+      expression_iterator<_DerivedTy> begin() const {
+        return { static_cast<_DerivedTy const&>( *this ), 0 };
+      }
+
+      expression_iterator<_DerivedTy> end() const {
+        auto const& derived = static_cast<_DerivedTy const&>( *this );
+        return { derived, static_cast<std::ptrdiff_t>( derived.extent() ) };
+      }
+    };
+// container referenced by an expression, views with <by_value> are copied.
+// lifetime : an expression holds no data, so every container in it must outlive it. that is always so inside
+// one full-expression ( m = lazy( a ) + b*k; ), but an expression kept in an <auto> variable must not name
+// a temporary : auto e = lazy( a ) + make(); leaves <e> referring to a destroyed matrix. lazy() refuses
+// temporaries, the operands after it are the caller's care
+template<class _Ty>
+    class expression_leaf : public expression_node<expression_leaf<_Ty>, typename expression_traits<_Ty>::result_t>
+    {
+      using traits_t = expression_traits<_Ty>;
+      std::conditional_t<is_expression_by_value<_Ty>::value, _Ty, _Ty const&> operand_;
+public :
+      using type_t = typename traits_t::type_t;
+
+      expression_leaf( _Ty const& operand )
+        : operand_( operand )
+      {
+      }
+
+      size_t extent() const {
+        return traits_t::extent( operand_ );
+      }
+
+      type_t eval( size_t i ) const {
+        return traits_t::eval( operand_, i );
+      }
+      // the leftmost container of an expression, a result takes its allocator from it
+      _Ty const& leaf() const noexcept {
+        return operand_;
+      }
+    };
+// nodes are stored by value, containers by reference
+template<class _Ty>
+    using expression_operand_t = std::conditional_t<is_expression_v<_Ty>, _Ty, expression_leaf<_Ty> >;
+
+template<class _Ty>
+    using expression_result_t = typename expression_operand_t<_Ty>::result_t;
+// the container operators evaluate at once, into a new container; lazy() opts in to the fused evaluation :
+// m = lazy( a ) + b - lazy( c )*k runs one loop and allocates at most once
+template<
+    class _Ty,
+    std::enable_if_t<is_expression_operand<_Ty>::value, bool> = true>
+    expression_leaf<_Ty> lazy( _Ty const& operand ) {
+      return { operand };
+    }
+
+template<class _Ty>
+    void lazy( _Ty const&& ) = delete;
+
+struct expression_add {
+  template<typename _Ty>
+    static _Ty apply( _Ty const& l, _Ty const& r ) { return l + r; }
+};
+
+struct expression_sub {
+  template<typename _Ty>
+    static _Ty apply( _Ty const& l, _Ty const& r ) { return l - r; }
+};
+
+struct expression_mul {
+  template<typename _Ty>
+    static _Ty apply( _Ty const& l, _Ty const& r ) { return l*r; }
+};
+// element-wise <l> op <r>
+template<
+    class _OpTy,
+    class _LeftTy,
+    class _RightTy>
+    class binary_expression
+      : public expression_node<binary_expression<_OpTy, _LeftTy, _RightTy>, typename _LeftTy::result_t>
+    {
+      static_assert(
+        std::is_same_v<typename _LeftTy::result_t, typename _RightTy::result_t>,
+        "< tvd::binary_expression > : operands have different <result_t>"
+      );
+
+      _LeftTy  l_;
+      _RightTy r_;
+public :
+      using type_t = typename _LeftTy::type_t;
+
+      binary_expression( _LeftTy const& l, _RightTy const& r )
+        : l_( l )
+        , r_( r )
+      {
+        if( l_.extent() != r_.extent() ) {
+            throw TVD_EXCEPTION( "<binary_expression::binary_expression> : <left.size> != <right.size>" );
+        }
+      }
+
+      size_t extent() const {
+        return l_.extent();
+      }
+
+      type_t eval( size_t i ) const {
+        return _OpTy::apply( l_.eval( i ), r_.eval( i ) );
+      }
+
+      auto const& leaf() const noexcept {
+        return l_.leaf();
+      }
+    };
+// element-wise <e> op <value>
+template<
+    class _OpTy,
+    class _ExprTy>
+    class scalar_expression
+      : public expression_node<scalar_expression<_OpTy, _ExprTy>, typename _ExprTy::result_t>
+    {
+      _ExprTy e_;
+public :
+      using type_t = typename _ExprTy::type_t;
+private :
+      type_t value_;
+public :
+      scalar_expression( _ExprTy const& e, type_t const& value )
+        : e_( e )
+        , value_( value )
+      {
+      }
+
+      size_t extent() const {
+        return e_.extent();
+      }
+
+      type_t eval( size_t i ) const {
+        return _OpTy::apply( e_.eval( i ), value_ );
+      }
+
+      auto const& leaf() const noexcept {
+        return e_.leaf();
+      }
+    };
+
+template<
+    class _OpTy,
+    class _LeftTy,
+    class _RightTy>
+    auto make_expression( _LeftTy const& l, _RightTy const& r )
+      -> binary_expression<_OpTy, expression_operand_t<_LeftTy>, expression_operand_t<_RightTy> >
+    {
+      return { expression_operand_t<_LeftTy>( l ), expression_operand_t<_RightTy>( r ) };
+    }
+
+template<
+    class _OpTy,
+    class _ExprTy>
+    auto make_scalar_expression( _ExprTy const& e, typename expression_operand_t<_ExprTy>::type_t const& value )
+      -> scalar_expression<_OpTy, expression_operand_t<_ExprTy> >
+    {
+      return { expression_operand_t<_ExprTy>( e ), value };
+    }
+// operators with an expression on at least one side, container-only operators live in the mixins
+template<
+    class _LeftTy,
+    class _RightTy>
+    using is_expression_pair_t = std::enable_if_t<
+      ( is_expression_v<_LeftTy> || is_expression_v<_RightTy> ) &&
+      is_expression_operand_v<_LeftTy> && is_expression_operand_v<_RightTy>,
+      bool
+    >;
+
+template<
+    class _LeftTy,
+    class _RightTy,
+    is_expression_pair_t<_LeftTy, _RightTy> = true>
+    auto operator + ( _LeftTy const& l, _RightTy const& r ) {
+      return make_expression<expression_add>( l, r );
+    }
+
+template<
+    class _LeftTy,
+    class _RightTy,
+    is_expression_pair_t<_LeftTy, _RightTy> = true>
+    auto operator - ( _LeftTy const& l, _RightTy const& r ) {
+      return make_expression<expression_sub>( l, r );
+    }
+
+template<
+    class _LeftTy,
+    class _RightTy,
+    is_expression_pair_t<_LeftTy, _RightTy> = true>
+    bool operator == ( _LeftTy const& l, _RightTy const& r )
+    {
+      const expression_operand_t<_LeftTy>  l_( l );
+      const expression_operand_t<_RightTy> r_( r );
+      if( l_.extent() != r_.extent() ) {
+          return false;
+      }
+      for( size_t i(0); i < l_.extent(); i++ ) {
+          if( l_.eval( i ) != r_.eval( i ) ) {
+              return false;
+          }
+      }
+      return true;
+    }
+
+template<
+    class _LeftTy,
+    class _RightTy,
+    is_expression_pair_t<_LeftTy, _RightTy> = true>
+    bool operator != ( _LeftTy const& l, _RightTy const& r ) {
+      return !( l == r );
+    }
+
+template<
+    class _ExprTy,
+    std::enable_if_t<is_expression_v<_ExprTy>, bool> = true>
+    auto operator * ( _ExprTy const& e, typename _ExprTy::type_t const& value ) {
+      return make_scalar_expression<expression_mul>( e, value );
+    }
+
+template<
+    class _ExprTy,
+    std::enable_if_t<is_expression_v<_ExprTy>, bool> = true>
+    auto operator / ( _ExprTy const& e, typename _ExprTy::type_t const& value )
+    {
+      if( value <= 0 ) {
+          throw TVD_EXCEPTION( "bad operation : value = 0" );
+      }
+      return make_scalar_expression<expression_mul>( e, typename _ExprTy::type_t( 1.0/value ) );
+    }
+} // tvd
+#endif
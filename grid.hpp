@@ -0,0 +1,10 @@
+#pragma once
+#ifndef TVD_GRID_HPP
+#define TVD_GRID_HPP
+# include "tvd/grid/batch.hpp"
+# include "tvd/grid/bit_grid.hpp"
+# include "tvd/grid/distance_field.hpp"
+# include "tvd/grid/hierarchy.hpp"
+# include "tvd/grid/planner.hpp"
+# include "tvd/grid/search.hpp"
+#endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the batched grid path search
+#pragma once
+#ifndef TVD_GRID_BATCH_HPP
+#define TVD_GRID_BATCH_HPP
+
+#include "tvd/thread_pool.hpp"
+#include "tvd/grid/search.hpp"
+
+#include <vector>
+
+namespace tvd {
+
+    struct grid_query
+    {
+      grid_point from;
+      grid_point to;
+    };
+// runs every query over the shared read-only <map> on the thread pool, each thread searching with its own
+// grid_workspace::local(), a grid_method::parallel query with a leased one; paths[i] answers queries[i]
+// and is empty when there is no path.
+// the inner vectors of <paths> keep their capacity, so reusing <paths> between calls does not allocate
+template<typename _Ty>
+    void grid_find_paths( grid_map<_Ty> const& map, std::vector<grid_query> const& queries,
+                          std::vector<std::vector<grid_point> > & paths, grid_method method = grid_method::bfs )
+    {
+      paths.resize( queries.size() );
+      const size_t grain = std::max<size_t>( 1, queries.size()/( 8*num_threads() ) );
+      tvd::parallel_for( 0, queries.size(), grain, [&]( size_t first, size_t last )
+      {
+        auto & ws = grid_workspace::local();
+        for( size_t i(first); i < last; i++ ) {
+            grid_find_path( ws, map, queries[i].from, queries[i].to, paths[i], method );
+        }
+      } );
+    }
+} // tvd
+#endif
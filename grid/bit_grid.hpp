@@ -0,0 +1,403 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the bit-packed occupancy grid
+#pragma once
+#ifndef TVD_GRID_BIT_GRID_HPP
+#define TVD_GRID_BIT_GRID_HPP
+
+#include "tvd/exception.hpp"
+#include "tvd/grid/search.hpp"
+#include "tvd/matrix/matrix_view.hpp"
+#include "tvd/matrix/simd.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace tvd {
+// one bit per cell, set for a free cell, 16x smaller than a uint16_t cell matrix; a row takes words() 64-bit words,
+// bit j of word w is the cell x = 64*w + j and the bits past the width stay clear
+    class bit_grid
+    {
+      size_t                width_;
+      size_t                height_;
+      size_t                words_;
+      std::vector<uint64_t> bits_;
+public :
+      bit_grid()
+        : width_( 0 )
+        , height_( 0 )
+        , words_( 0 )
+      {
+      }
+      // every cell blocked
+      bit_grid( size_t width, size_t height )
+        : width_( width )
+        , height_( height )
+        , words_( ( width + 63 )/64 )
+        , bits_( words_*height, 0 )
+      {
+      }
+
+  template<typename _Ty>
+      explicit bit_grid( grid_map<_Ty> const& map )
+        : bit_grid( map.width, map.height )
+      {
+        for( size_t y(0); y < height_; y++ )
+        {
+            const _Ty *row  = map.cells + y*width_;
+            uint64_t  *bits = bits_.data() + y*words_;
+            for( size_t x(0); x < width_; x++ ) {
+                bits[x/64] |= uint64_t( row[x] == map.blank ) << ( x%64 );
+            }
+        }
+      }
+
+  template<
+      typename _Ty,
+      class _ElemTraitsTy>
+      bit_grid( matrix_view<_Ty, _ElemTraitsTy> const& map, _Ty blank )
+        : bit_grid( grid_map<_Ty>( map, blank ) )
+      {
+      }
+
+      size_t width() const noexcept {
+        return width_;
+      }
+
+      size_t height() const noexcept {
+        return height_;
+      }
+      // words per row
+      size_t words() const noexcept {
+        return words_;
+      }
+
+      const uint64_t* data() const noexcept {
+        return bits_.data();
+      }
+
+      const uint64_t* row( size_t y ) const noexcept {
+        return bits_.data() + y*words_;
+      }
+
+      size_t bytes() const noexcept {
+        return bits_.size()*sizeof(uint64_t);
+      }
+
+      bool contains( grid_point const& p ) const noexcept {
+        return p.x < width_ && p.y < height_;
+      }
+
+      bool free( size_t x, size_t y ) const noexcept {
+        return ( bits_[y*words_ + x/64] >> ( x%64 ) ) & 1;
+      }
+
+      void set( size_t x, size_t y, bool free ) noexcept
+      {
+        uint64_t & word = bits_[y*words_ + x/64];
+        const uint64_t bit = uint64_t(1) << ( x%64 );
+        word = free ? ( word | bit ) : ( word & ~bit );
+      }
+    };
+
+    namespace detail {
+      // bit planes of a wavefront, per thread and grow-only
+      struct bit_grid_buffers
+      {
+        std::vector<uint64_t> visited;
+        std::vector<uint64_t> frontier;
+        std::vector<uint64_t> next;
+        // level%3 of every visited cell in two planes : 0 -> (0, 0), 1 -> (1, 0), 2 -> (0, 1)
+        std::vector<uint64_t> label[2];
+        // [lo, hi) words of every row holding set bits, of the frontier and of the next level
+        struct row_span
+        {
+          size_t lo;
+          size_t hi;
+        };
+        std::vector<row_span> span[2];
+        // stands in for the missing frontier row above the first and below the last row
+        std::vector<uint64_t> zero;
+
+        static bit_grid_buffers & local()
+        {
+          thread_local bit_grid_buffers buffers;
+          return buffers;
+        }
+
+        void prepare( size_t words, size_t height )
+        {
+          for( auto * plane : { &visited, &frontier, &next, &label[0], &label[1] } ) {
+              plane->assign( words*height, 0 );
+          }
+          for( auto & s : span ) {
+              s.assign( height, row_span{ words, 0 } );
+          }
+          zero.assign( words, 0 );
+        }
+      };
+      // one row of a wavefront level : the frontier rows <f>, <up> and <down>, the free bits <fr>,
+      // the visited bits <vr>, the next level <nr> and the label plane <lr>, null on the levels with no label
+      struct bit_grid_row
+      {
+        const uint64_t *f;
+        const uint64_t *up;
+        const uint64_t *down;
+        const uint64_t *fr;
+        uint64_t       *vr;
+        uint64_t       *nr;
+        uint64_t       *lr;
+        size_t          words;
+      };
+
+      inline void bit_grid_word( bit_grid_row const& r, size_t w ) noexcept
+      {
+        const uint64_t prev = w > 0 ? r.f[w - 1] : 0;
+        const uint64_t post = w + 1 < r.words ? r.f[w + 1] : 0;
+        uint64_t n = r.f[w] | ( r.f[w] << 1 ) | ( prev >> 63 ) | ( r.f[w] >> 1 ) | ( post << 63 );
+        n |= r.up[w] | r.down[w];
+        n &= r.fr[w] & ~r.vr[w];
+        r.nr[w]  = n;
+        r.vr[w] |= n;
+        if( r.lr ) {
+            r.lr[w] |= n;
+        }
+      }
+      // words [lo, hi) of the next level of a row
+      inline void bit_grid_words( bit_grid_row const& r, size_t lo, size_t hi ) noexcept
+      {
+        for( size_t w(lo); w < hi; w++ ) {
+            bit_grid_word( r, w );
+        }
+      }
+#ifdef TVD_SIMD_X86
+      // the first and the last word of a row have no neighbour word on one side, they stay scalar
+      TVD_SIMD_TARGET( "avx2" ) inline void bit_grid_words_avx2( bit_grid_row const& r, size_t lo, size_t hi ) noexcept
+      {
+        size_t w = lo;
+        if( w == 0 && w < hi ) {
+            bit_grid_word( r, w++ );
+        }
+        const size_t end = std::min( hi, r.words - 1 );
+        for( ; w + 4 <= end; w += 4 )
+        {
+            const __m256i f    = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( r.f + w ) );
+            const __m256i prev = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( r.f + w - 1 ) );
+            const __m256i post = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( r.f + w + 1 ) );
+            const __m256i up   = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( r.up + w ) );
+            const __m256i down = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( r.down + w ) );
+            const __m256i fr   = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( r.fr + w ) );
+            const __m256i v    = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( r.vr + w ) );
+            __m256i n = _mm256_or_si256( _mm256_or_si256( f, _mm256_slli_epi64( f, 1 ) ), _mm256_srli_epi64( f, 1 ) );
+            n = _mm256_or_si256( n, _mm256_or_si256( _mm256_srli_epi64( prev, 63 ), _mm256_slli_epi64( post, 63 ) ) );
+            n = _mm256_andnot_si256( v, _mm256_and_si256( _mm256_or_si256( n, _mm256_or_si256( up, down ) ), fr ) );
+            _mm256_storeu_si256( reinterpret_cast<__m256i*>( r.nr + w ), n );
+            _mm256_storeu_si256( reinterpret_cast<__m256i*>( r.vr + w ), _mm256_or_si256( v, n ) );
+            if( r.lr ) {
+                __m256i *l = reinterpret_cast<__m256i*>( r.lr + w );
+                _mm256_storeu_si256( l, _mm256_or_si256( _mm256_loadu_si256( l ), n ) );
+            }
+        }
+        for( ; w < hi; w++ ) {
+            bit_grid_word( r, w );
+        }
+      }
+
+      TVD_SIMD_TARGET( "avx512f,avx512bw,avx512dq" ) inline void bit_grid_words_avx512( bit_grid_row const& r, size_t lo, size_t hi ) noexcept
+      {
+        size_t w = lo;
+        if( w == 0 && w < hi ) {
+            bit_grid_word( r, w++ );
+        }
+        const size_t end = std::min( hi, r.words - 1 );
+        for( ; w + 8 <= end; w += 8 )
+        {
+            const __m512i f    = _mm512_loadu_si512( r.f + w );
+            const __m512i prev = _mm512_loadu_si512( r.f + w - 1 );
+            const __m512i post = _mm512_loadu_si512( r.f + w + 1 );
+            const __m512i up   = _mm512_loadu_si512( r.up + w );
+            const __m512i down = _mm512_loadu_si512( r.down + w );
+            const __m512i fr   = _mm512_loadu_si512( r.fr + w );
+            const __m512i v    = _mm512_loadu_si512( r.vr + w );
+            // ternary logic 0xfe is a | b | c and 0x08 is ~a & b & c; the zero-masked shifts keep every lane
+            const __mmask8 all = 0xff;
+            __m512i n = _mm512_ternarylogic_epi64( f, _mm512_maskz_slli_epi64( all, f, 1 ), _mm512_maskz_srli_epi64( all, f, 1 ), 0xfe );
+            n = _mm512_ternarylogic_epi64( n, _mm512_maskz_srli_epi64( all, prev, 63 ), _mm512_maskz_slli_epi64( all, post, 63 ), 0xfe );
+            n = _mm512_ternarylogic_epi64( v, _mm512_ternarylogic_epi64( n, up, down, 0xfe ), fr, 0x08 );
+            _mm512_storeu_si512( r.nr + w, n );
+            _mm512_storeu_si512( r.vr + w, _mm512_or_si512( v, n ) );
+            if( r.lr ) {
+                _mm512_storeu_si512( r.lr + w, _mm512_or_si512( _mm512_loadu_si512( r.lr + w ), n ) );
+            }
+        }
+        for( ; w < hi; w++ ) {
+            bit_grid_word( r, w );
+        }
+      }
+#endif
+      // the word kernel of the active instruction set
+      using bit_grid_kernel_t = void (*)( bit_grid_row const&, size_t, size_t ) noexcept;
+
+      inline bit_grid_kernel_t bit_grid_kernel() noexcept
+      {
+#ifdef TVD_SIMD_X86
+        switch( simd::isa() )
+        {
+          case simd::isa_t::avx512 : return bit_grid_words_avx512;
+          case simd::isa_t::avx2   : return bit_grid_words_avx2;
+          default                  : break;
+        }
+#endif
+        return bit_grid_words;
+      }
+
+      inline bool bit_test( std::vector<uint64_t> const& plane, size_t w, size_t x ) noexcept {
+        return ( plane[w + x/64] >> ( x%64 ) ) & 1;
+      }
+    } // detail
+// wavefront advanced a whole level at a time on 64-cell words : a word of the next level is
+// ( its frontier word shifted by one cell both ways, with the bits carried over from the neighbour words,
+//   or the frontier words above and below ) and the free bits and not the visited bits.
+// only the words next to set frontier words are swept, 4 or 8 words a step by the kernel of simd::isa(), and the
+// spans of the next level are found after the sweep, from its first and last set words. the path is traced back
+// through the level%3 labels : the neighbours of a level <d> cell are at <d> - 1, <d> or <d> + 1
+    inline bool grid_find_path( bit_grid const& grid, grid_point from, grid_point to, std::vector<grid_point> & path )
+    {
+      path.clear();
+      if( !grid.contains( from ) || !grid.contains( to ) ) {
+          throw TVD_EXCEPTION( "<tvd::grid_find_path> : out of range" );
+      }
+      if( !grid.free( from.x, from.y ) || !grid.free( to.x, to.y ) ) {
+          return false;
+      }
+      if( from == to ) {
+          path.push_back( from );
+          return true;
+      }
+
+      const size_t words  = grid.words();
+      const size_t height = grid.height();
+      auto & b = detail::bit_grid_buffers::local();
+      b.prepare( words, height );
+      const auto kernel = detail::bit_grid_kernel();
+
+      const uint64_t *free = grid.data();
+      uint64_t *visited  = b.visited.data();
+      uint64_t *frontier = b.frontier.data();
+      uint64_t *next     = b.next.data();
+      auto     *f_span   = b.span[0].data();
+      auto     *n_span   = b.span[1].data();
+
+      const size_t target_word = to.y*words + to.x/64;
+      const uint64_t target_bit = uint64_t(1) << ( to.x%64 );
+      frontier[from.y*words + from.x/64] = uint64_t(1) << ( from.x%64 );
+      visited[from.y*words + from.x/64]  = frontier[from.y*words + from.x/64];
+      f_span[from.y] = { from.x/64, from.x/64 + 1 };
+
+      size_t first = from.y, last = from.y;
+      size_t level = 0;
+      for( ;; )
+      {
+          level++;
+          const size_t r0 = first > 0 ? first - 1 : 0;
+          const size_t r1 = std::min( last + 1, height - 1 );
+          size_t n_first = height, n_last = 0;
+          uint64_t *label = level%3 == 1 ? b.label[0].data() : level%3 == 2 ? b.label[1].data() : nullptr;
+
+          for( size_t r(r0); r <= r1; r++ )
+          {
+              // words reached from the frontier words of the row, widened by one, and of the rows above and below
+              size_t lo = words, hi = 0;
+              if( f_span[r].lo < f_span[r].hi ) {
+                  lo = f_span[r].lo > 0 ? f_span[r].lo - 1 : 0;
+                  hi = std::min( f_span[r].hi + 1, words );
+              }
+              if( r > 0 && f_span[r - 1].lo < f_span[r - 1].hi ) {
+                  lo = std::min( lo, f_span[r - 1].lo );
+                  hi = std::max( hi, f_span[r - 1].hi );
+              }
+              if( r + 1 < height && f_span[r + 1].lo < f_span[r + 1].hi ) {
+                  lo = std::min( lo, f_span[r + 1].lo );
+                  hi = std::max( hi, f_span[r + 1].hi );
+              }
+              n_span[r] = { words, 0 };
+              if( lo >= hi ) {
+                  continue;
+              }
+
+              const detail::bit_grid_row row
+              {
+                frontier + r*words,
+                r > 0 ? frontier + ( r - 1 )*words : b.zero.data(),
+                r + 1 < height ? frontier + ( r + 1 )*words : b.zero.data(),
+                free + r*words,
+                visited + r*words,
+                next + r*words,
+                label ? label + r*words : nullptr,
+                words
+              };
+              kernel( row, lo, hi );
+              // the next words outside [lo, hi) are clear, the span is trimmed to the set words inside it
+              while( lo < hi && row.nr[lo] == 0 ) {
+                  lo++;
+              }
+              while( hi > lo && row.nr[hi - 1] == 0 ) {
+                  hi--;
+              }
+              if( lo < hi ) {
+                  n_span[r] = { lo, hi };
+                  n_first = std::min( n_first, r );
+                  n_last  = r;
+              }
+          }
+          // the old frontier words are cleared, so a buffer is all zero outside the spans it records
+          for( size_t r(first); r <= last; r++ )
+          {
+              if( f_span[r].lo < f_span[r].hi ) {
+                  std::fill( frontier + r*words + f_span[r].lo, frontier + r*words + f_span[r].hi, 0 );
+              }
+              f_span[r] = { words, 0 };
+          }
+          if( n_first == height ) {
+              return false;
+          }
+          std::swap( frontier, next );
+          std::swap( f_span, n_span );
+          first = n_first;
+          last  = n_last;
+          if( frontier[target_word] & target_bit ) {
+              break;
+          }
+      }
+
+      // back from the target, one neighbour with the previous label per level
+      auto label_of = [&]( size_t x, size_t y ) -> size_t
+      {
+        const size_t w = y*words;
+        return detail::bit_test( b.label[0], w, x ) ? 1 : detail::bit_test( b.label[1], w, x ) ? 2 : 0;
+      };
+      auto reached = [&]( size_t x, size_t y ) {
+        return detail::bit_test( b.visited, y*words, x );
+      };
+
+      path.resize( level + 1 );
+      grid_point p = to;
+      path[level] = p;
+      for( size_t d(level); d > 0; d-- )
+      {
+          const size_t want = ( d - 1 )%3;
+          if( p.x + 1 < grid.width() && reached( p.x + 1, p.y ) && label_of( p.x + 1, p.y ) == want ) {
+              p.x++;
+          } else if( p.y + 1 < height && reached( p.x, p.y + 1 ) && label_of( p.x, p.y + 1 ) == want ) {
+              p.y++;
+          } else if( p.x > 0 && reached( p.x - 1, p.y ) && label_of( p.x - 1, p.y ) == want ) {
+              p.x--;
+          } else {
+              p.y--;
+          }
+          path[d - 1] = p;
+      }
+      return true;
+    }
+} // tvd
+#endif
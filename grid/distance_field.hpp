@@ -0,0 +1,161 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the grid distance field
+#pragma once
+#ifndef TVD_GRID_DISTANCE_FIELD_HPP
+#define TVD_GRID_DISTANCE_FIELD_HPP
+
+#include "tvd/exception.hpp"
+#include "tvd/grid/search.hpp"
+#include "tvd/matrix/matrix.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace tvd {
+    // distance of the cells no seed reaches
+    inline constexpr uint32_t grid_unreachable = grid_workspace::none;
+    // distance field of a map whose width is known at run time, at( x, y ) answers the cell (x, y)
+    struct grid_distances
+    {
+      std::vector<uint32_t> distances;
+      size_t                width  = 0;
+      size_t                height = 0;
+
+      uint32_t at( size_t x, size_t y ) const noexcept {
+        return distances[y*width + x];
+      }
+
+      const uint32_t* data() const noexcept {
+        return distances.data();
+      }
+    };
+
+    namespace detail {
+      // multi-source wavefront, out[c] is the step count from the nearest seed; blocked seeds are skipped
+  template<typename _Ty>
+      void grid_flood( grid_map<_Ty> const& map, std::vector<grid_point> const& seeds, uint32_t *out )
+      {
+        // cell indices and step counts share uint32_t, grid_unreachable included
+        if( map.size() >= grid_unreachable ) {
+            throw TVD_EXCEPTION( "<tvd::distance_field> : grid is too large" );
+        }
+        std::fill( out, out + map.size(), grid_unreachable );
+        grid_ring ring;
+        for( auto const& seed : seeds )
+        {
+            if( !map.contains( seed ) ) {
+                throw TVD_EXCEPTION( "<tvd::distance_field> : seed out of range" );
+            }
+            const size_t c = map.index( seed );
+            if( map.free( c ) && out[c] != 0 ) {
+                out[c] = 0;
+                ring.push( static_cast<uint32_t>( c ) );
+            }
+        }
+        while( !ring.empty() )
+        {
+            const size_t c = ring.pop();
+            const uint32_t d = out[c] + 1;
+            grid_neighbours( map, c, [&]( size_t n )
+            {
+              if( out[n] == grid_unreachable ) {
+                  out[n] = d;
+                  ring.push( static_cast<uint32_t>( n ) );
+              }
+            } );
+        }
+      }
+      // downhill walk over the <width> x <height> field <d>
+      inline bool distance_path( const uint32_t *d, size_t width, size_t height, grid_point to, std::vector<grid_point> & path )
+      {
+        path.clear();
+        if( to.x >= width || to.y >= height ) {
+            throw TVD_EXCEPTION( "<tvd::distance_field_path> : out of range" );
+        }
+        size_t c = to.y*width + to.x;
+        if( d[c] == grid_unreachable ) {
+            return false;
+        }
+
+        path.reserve( d[c] + 1 );
+        path.push_back( to );
+        while( d[c] != 0 )
+        {
+            const size_t   x    = c%width;
+            const uint32_t next = d[c] - 1;
+            if( x + 1 < width && d[c + 1] == next ) {
+                c = c + 1;
+            } else if( c + width < width*height && d[c + width] == next ) {
+                c = c + width;
+            } else if( x > 0 && d[c - 1] == next ) {
+                c = c - 1;
+            } else if( c >= width && d[c - width] == next ) {
+                c = c - width;
+            } else {
+                throw TVD_EXCEPTION( "<tvd::distance_field_path> : <field> is not a distance field" );
+            }
+            path.push_back( { c%width, c/width } );
+        }
+        std::reverse( path.begin(), path.end() );
+        return true;
+      }
+    } // detail
+// distances of every cell of <map> to the nearest of <seeds>, grid_unreachable for the cells none reaches;
+// field[y][x] answers the cell (x, y), <col_size> must be the map width; see below for a width known at run time
+template<
+    size_t col_size,
+    typename _Ty>
+    matrix<uint32_t, col_size> distance_field( grid_map<_Ty> const& map, std::vector<grid_point> const& seeds )
+    {
+      if( map.width != col_size ) {
+          throw TVD_EXCEPTION( "<tvd::distance_field> : <map.width> != <col_size>" );
+      }
+      matrix<uint32_t, col_size> field( map.height );
+      detail::grid_flood( map, seeds, field.data() );
+      return field;
+    }
+
+template<
+    size_t col_size,
+    typename _Ty>
+    matrix<uint32_t, col_size> distance_field( grid_map<_Ty> const& map, grid_point seed ) {
+      return distance_field<col_size>( map, std::vector<grid_point>{ seed } );
+    }
+// the same for any map width : <out> gets map.size() distances, out[y*map.width + x] answers the cell (x, y)
+template<typename _Ty>
+    void distance_field( grid_map<_Ty> const& map, std::vector<grid_point> const& seeds, uint32_t *out ) {
+      detail::grid_flood( map, seeds, out );
+    }
+
+template<typename _Ty>
+    grid_distances distance_field( grid_map<_Ty> const& map, std::vector<grid_point> const& seeds )
+    {
+      grid_distances field;
+      field.distances.resize( map.size() );
+      field.width  = map.width;
+      field.height = map.height;
+      detail::grid_flood( map, seeds, field.distances.data() );
+      return field;
+    }
+
+template<typename _Ty>
+    grid_distances distance_field( grid_map<_Ty> const& map, grid_point seed ) {
+      return distance_field( map, std::vector<grid_point>{ seed } );
+    }
+// walks the field downhill from <to> to the seed it is nearest to, <path> gets it seed first;
+// false when no seed reaches <to>. O(path length), the wave is not run again
+template<
+    size_t col_size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    bool distance_field_path( matrix<uint32_t, col_size, _ElemTraitsTy, _AllocTy> const& field, grid_point to,
+                              std::vector<grid_point> & path ) {
+      return detail::distance_path( field.data(), col_size, field.size(), to, path );
+    }
+
+    inline bool distance_field_path( grid_distances const& field, grid_point to, std::vector<grid_point> & path ) {
+      return detail::distance_path( field.data(), field.width, field.height, to, path );
+    }
+} // tvd
+#endif
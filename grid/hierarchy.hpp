@@ -0,0 +1,518 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the hierarchical grid path index
+#pragma once
+#ifndef TVD_GRID_HIERARCHY_HPP
+#define TVD_GRID_HIERARCHY_HPP
+
+#include "tvd/exception.hpp"
+#include "tvd/thread_pool.hpp"
+#include "tvd/grid/search.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <queue>
+#include <vector>
+
+namespace tvd {
+
+    namespace detail {
+      // [x0, x1) x [y0, y1) part of a grid
+      struct grid_rect
+      {
+        size_t x0;
+        size_t y0;
+        size_t x1;
+        size_t y1;
+
+        bool contains( size_t x, size_t y ) const noexcept {
+          return x >= x0 && x < x1 && y >= y0 && y < y1;
+        }
+      };
+      // wavefront from <s> that never leaves <rect>, stops once <t> is reached;
+      // the distances and parents are left in <ws>
+  template<typename _Ty>
+      void grid_bounded_bfs( grid_workspace & ws, grid_map<_Ty> const& map, grid_rect const& rect,
+                             size_t s, size_t t = grid_workspace::none )
+      {
+        ws.prepare( map.size() );
+        auto & ring = ws.ring( 0 );
+        ws.visit( s, 0, 0, grid_workspace::none );
+        ring.push( static_cast<uint32_t>( s ) );
+        while( !ring.empty() )
+        {
+            const size_t c = ring.pop();
+            if( c == t ) {
+                return;
+            }
+            const uint32_t d = ws.distance( c ) + 1;
+            grid_neighbours( map, c, [&]( size_t n )
+            {
+              if( !ws.seen( n ) && rect.contains( n%map.width, n/map.width ) ) {
+                  ws.visit( n, 0, d, static_cast<uint32_t>( c ) );
+                  ring.push( static_cast<uint32_t>( n ) );
+              }
+            } );
+        }
+      }
+
+  template<typename _Ty>
+      void write_pod( std::ostream & o, _Ty const& value ) {
+        o.write( reinterpret_cast<const char*>( &value ), sizeof(_Ty) );
+      }
+
+  template<typename _Ty>
+      void write_pod( std::ostream & o, std::vector<_Ty> const& values )
+      {
+        write_pod( o, static_cast<uint64_t>( values.size() ) );
+        o.write( reinterpret_cast<const char*>( values.data() ), values.size()*sizeof(_Ty) );
+      }
+
+  template<typename _Ty>
+      void read_pod( std::istream & i, _Ty & value ) {
+        i.read( reinterpret_cast<char*>( &value ), sizeof(_Ty) );
+      }
+
+  template<typename _Ty>
+      void read_pod( std::istream & i, std::vector<_Ty> & values )
+      {
+        uint64_t size = 0;
+        read_pod( i, size );
+        if( !i || size > ( uint64_t(1) << 40 )/sizeof(_Ty) ) {
+            throw TVD_EXCEPTION( "<tvd::read_pod> : bad size" );
+        }
+        // grown a chunk at a time : a corrupt size ends in a short read, not in a huge allocation
+        constexpr uint64_t chunk = ( uint64_t(1) << 20 )/sizeof(_Ty);
+        values.clear();
+        while( i && values.size() < size )
+        {
+            const size_t first = values.size();
+            values.resize( first + std::min( chunk, size - first ) );
+            i.read( reinterpret_cast<char*>( values.data() + first ), ( values.size() - first )*sizeof(_Ty) );
+        }
+      }
+    } // detail
+// HPA* index of a static grid_map : the map is cut into <cluster> x <cluster> blocks, every run of free cells along
+// a block border gets one entrance (two at the ends of a run of 6 or more), and the distances between the entrances
+// of a block are computed once. a query links its ends to the entrances of their blocks, searches the abstract graph
+// and refines every abstract edge with a search bounded by one block. the paths are near-shortest, not shortest.
+// the index keeps no pointer to the map, find_path() is given the same map it was built over
+    class grid_hierarchy
+    {
+      static constexpr uint32_t format_version = 1;
+      static constexpr uint32_t inf = grid_workspace::none;
+
+      uint64_t              width_;
+      uint64_t              height_;
+      uint64_t              cluster_;
+      uint64_t              checksum_;
+      std::vector<uint32_t> cells_;            // cell of every node, sorted
+      std::vector<uint32_t> cluster_offsets_;  // nodes of the block k are cluster_nodes_[offsets[k], offsets[k + 1])
+      std::vector<uint32_t> cluster_nodes_;
+      std::vector<uint32_t> edge_offsets_;     // edges of the node v are [offsets[v], offsets[v + 1])
+      std::vector<uint32_t> edge_targets_;
+      std::vector<uint32_t> edge_costs_;
+public :
+      grid_hierarchy()
+        : width_( 0 )
+        , height_( 0 )
+        , cluster_( 0 )
+        , checksum_( 0 )
+      {
+      }
+
+  template<typename _Ty>
+      explicit grid_hierarchy( grid_map<_Ty> const& map, size_t cluster = 16 )
+        : width_( map.width )
+        , height_( map.height )
+        , cluster_( cluster )
+        , checksum_( fingerprint( map ) )
+      {
+        if( cluster < 2 ) {
+            throw TVD_EXCEPTION( "<grid_hierarchy::grid_hierarchy> : <cluster> < 2" );
+        }
+        if( map.size() >= inf ) {
+            throw TVD_EXCEPTION( "<grid_hierarchy::grid_hierarchy> : grid is too large" );
+        }
+        build( map );
+      }
+      // true when <map> has the size and the free cells the index was built over
+  template<typename _Ty>
+      bool matches( grid_map<_Ty> const& map ) const {
+        return map.width == width_ && map.height == height_ && fingerprint( map ) == checksum_;
+      }
+
+      size_t nodes() const noexcept {
+        return cells_.size();
+      }
+
+      size_t edges() const noexcept {
+        return edge_targets_.size();
+      }
+
+      size_t cluster() const noexcept {
+        return cluster_;
+      }
+      // near-shortest 4-connected path, <path> gets it source first; false when the cells are not connected
+  template<typename _Ty>
+      bool find_path( grid_map<_Ty> const& map, grid_point from, grid_point to, std::vector<grid_point> & path ) const
+      {
+        path.clear();
+        if( map.width != width_ || map.height != height_ ) {
+            throw TVD_EXCEPTION( "<grid_hierarchy::find_path> : the map is not the indexed one" );
+        }
+        if( !map.contains( from ) || !map.contains( to ) ) {
+            throw TVD_EXCEPTION( "<grid_hierarchy::find_path> : out of range" );
+        }
+        const size_t s = map.index( from );
+        const size_t t = map.index( to );
+        if( !map.free( s ) || !map.free( t ) ) {
+            return false;
+        }
+        if( s == t ) {
+            path.push_back( from );
+            return true;
+        }
+
+        // the ends are the virtual nodes n and n + 1, linked to the reachable entrances of their blocks
+        auto & ws = grid_workspace::local();
+        const size_t n = nodes();
+        std::vector<std::pair<uint32_t, uint32_t> > source_links, target_links;
+        uint32_t direct = inf;
+        detail::grid_bounded_bfs( ws, map, rect( cluster_of( s ) ), s );
+        if( cluster_of( s ) == cluster_of( t ) && ws.visited( t ) ) {
+            direct = ws.distance( t );
+        }
+        link( ws, cluster_of( s ), source_links );
+        detail::grid_bounded_bfs( ws, map, rect( cluster_of( t ) ), t );
+        link( ws, cluster_of( t ), target_links );
+
+        std::vector<uint32_t> g( n + 2, inf ), parent( n + 2, inf );
+        using open_t = std::pair<uint64_t, uint32_t>;
+        std::priority_queue<open_t, std::vector<open_t>, std::greater<open_t> > open;
+        auto h = [&]( size_t c ) -> uint64_t
+        {
+          const size_t x = c%width_, y = c/width_, tx = t%width_, ty = t/width_;
+          return ( x > tx ? x - tx : tx - x ) + ( y > ty ? y - ty : ty - y );
+        };
+        // f in the high half, ties go to the larger g, which is the nearer to the target
+        auto key = [&]( uint32_t v ) -> uint64_t {
+          return ( ( g[v] + ( v == n + 1 ? 0 : h( v == n ? s : cells_[v] ) ) ) << 32 ) | ( inf - g[v] );
+        };
+        auto relax = [&]( uint32_t v, uint32_t u, uint32_t cost )
+        {
+          if( g[u] + cost < g[v] ) {
+              g[v]      = g[u] + cost;
+              parent[v] = u;
+              open.push( { key( v ), v } );
+          }
+        };
+
+        g[n] = 0;
+        open.push( { key( static_cast<uint32_t>( n ) ), static_cast<uint32_t>( n ) } );
+        while( !open.empty() )
+        {
+            const open_t top = open.top();
+            open.pop();
+            const uint32_t u = top.second;
+            if( u == n + 1 ) {
+                break;
+            }
+            if( top.first != key( u ) ) {
+                continue;
+            }
+            if( u == n ) {
+                for( auto const& l : source_links ) {
+                    relax( l.first, u, l.second );
+                }
+                if( direct != inf ) {
+                    relax( static_cast<uint32_t>( n + 1 ), u, direct );
+                }
+                continue;
+            }
+            for( size_t e( edge_offsets_[u] ); e < edge_offsets_[u + 1]; e++ ) {
+                relax( edge_targets_[e], u, edge_costs_[e] );
+            }
+            for( auto const& l : target_links ) {
+                if( l.first == u ) {
+                    relax( static_cast<uint32_t>( n + 1 ), u, l.second );
+                }
+            }
+        }
+        if( g[n + 1] == inf ) {
+            return false;
+        }
+
+        std::vector<size_t> route;
+        for( uint32_t v( static_cast<uint32_t>( n + 1 ) ); v != inf; v = parent[v] ) {
+            route.push_back( v == n ? s : v == n + 1 ? t : cells_[v] );
+        }
+        std::reverse( route.begin(), route.end() );
+        path.push_back( from );
+        for( size_t i(1); i < route.size(); i++ ) {
+            refine( ws, map, route[i - 1], route[i], path );
+        }
+        return true;
+      }
+      // binary image of the index in the byte order of the host
+      void save( std::ostream & o ) const
+      {
+        o.write( "TVDH", 4 );
+        detail::write_pod( o, format_version );
+        detail::write_pod( o, width_ );
+        detail::write_pod( o, height_ );
+        detail::write_pod( o, cluster_ );
+        detail::write_pod( o, checksum_ );
+        for( auto * v : { &cells_, &cluster_offsets_, &cluster_nodes_, &edge_offsets_, &edge_targets_, &edge_costs_ } ) {
+            detail::write_pod( o, *v );
+        }
+        if( !o ) {
+            throw TVD_EXCEPTION( "<grid_hierarchy::save> : write failed" );
+        }
+      }
+
+      static grid_hierarchy load( std::istream & i )
+      {
+        char magic[4] = {};
+        uint32_t version = 0;
+        i.read( magic, 4 );
+        detail::read_pod( i, version );
+        if( !i || !std::equal( magic, magic + 4, "TVDH" ) || version != format_version ) {
+            throw TVD_EXCEPTION( "<grid_hierarchy::load> : not a grid_hierarchy image" );
+        }
+        grid_hierarchy index;
+        detail::read_pod( i, index.width_ );
+        detail::read_pod( i, index.height_ );
+        detail::read_pod( i, index.cluster_ );
+        detail::read_pod( i, index.checksum_ );
+        for( auto * v : { &index.cells_, &index.cluster_offsets_, &index.cluster_nodes_,
+                          &index.edge_offsets_, &index.edge_targets_, &index.edge_costs_ } ) {
+            detail::read_pod( i, *v );
+        }
+        if( !i ) {
+            throw TVD_EXCEPTION( "<grid_hierarchy::load> : truncated image" );
+        }
+        if( !index.consistent() ) {
+            throw TVD_EXCEPTION( "<grid_hierarchy::load> : corrupt image" );
+        }
+        return index;
+      }
+private :
+      // every offset table starts at 0, never decreases and ends at the size of the array it indexes,
+      // every index is inside its array : a loaded image is never trusted further than this
+      bool consistent() const
+      {
+        if( cluster_ < 2 || width_ == 0 || height_ == 0 || width_ >= inf || height_ >= inf || width_*height_ >= inf ) {
+            return false;
+        }
+        auto offsets = []( std::vector<uint32_t> const& offs, size_t items, size_t size )
+        {
+          if( offs.size() != items + 1 || offs.front() != 0 || offs.back() != size ) {
+              return false;
+          }
+          return std::is_sorted( offs.begin(), offs.end() );
+        };
+        const size_t cells = width_*height_, n = cells_.size();
+        const size_t blocks = clusters_x()*clusters_y();
+        if( !offsets( cluster_offsets_, blocks, cluster_nodes_.size() ) || !offsets( edge_offsets_, n, edge_targets_.size() )
+            || cluster_nodes_.size() != n || edge_costs_.size() != edge_targets_.size() ) {
+            return false;
+        }
+        // the cells are sorted without repeats, node_of() searches them
+        for( size_t v(0); v < n; v++ ) {
+            if( cells_[v] >= cells || ( v != 0 && cells_[v] <= cells_[v - 1] ) ) {
+                return false;
+            }
+        }
+        for( size_t k(0); k < blocks; k++ ) {
+            for( size_t i( cluster_offsets_[k] ); i < cluster_offsets_[k + 1]; i++ ) {
+                if( cluster_nodes_[i] >= n || cluster_of( cells_[cluster_nodes_[i]] ) != k ) {
+                    return false;
+                }
+            }
+        }
+        for( size_t v(0); v < n; v++ ) {
+            for( size_t e( edge_offsets_[v] ); e < edge_offsets_[v + 1]; e++ ) {
+                if( edge_targets_[e] >= n || edge_costs_[e] >= cells ) {
+                    return false;
+                }
+            }
+        }
+        return true;
+      }
+
+  template<typename _Ty>
+      static uint64_t fingerprint( grid_map<_Ty> const& map )
+      {
+        // FNV-1a over the free flags
+        uint64_t hash = 14695981039346656037ull;
+        for( size_t c(0); c < map.size(); c++ ) {
+            hash = ( hash ^ uint64_t( map.free( c ) ) )*1099511628211ull;
+        }
+        return hash;
+      }
+
+      size_t clusters_x() const noexcept {
+        return ( width_ + cluster_ - 1 )/cluster_;
+      }
+
+      size_t clusters_y() const noexcept {
+        return ( height_ + cluster_ - 1 )/cluster_;
+      }
+
+      size_t cluster_of( size_t c ) const noexcept {
+        return ( c/width_/cluster_ )*clusters_x() + ( c%width_ )/cluster_;
+      }
+
+      detail::grid_rect rect( size_t k ) const noexcept
+      {
+        const size_t x0 = ( k%clusters_x() )*cluster_, y0 = ( k/clusters_x() )*cluster_;
+        return { x0, y0, std::min<size_t>( x0 + cluster_, width_ ), std::min<size_t>( y0 + cluster_, height_ ) };
+      }
+
+      size_t node_of( size_t c ) const noexcept {
+        return std::lower_bound( cells_.begin(), cells_.end(), static_cast<uint32_t>( c ) ) - cells_.begin();
+      }
+      // entrances of the block <k> reached by the last bounded search, with their distances
+      void link( grid_workspace const& ws, size_t k, std::vector<std::pair<uint32_t, uint32_t> > & links ) const
+      {
+        for( size_t i( cluster_offsets_[k] ); i < cluster_offsets_[k + 1]; i++ ) {
+            const uint32_t v = cluster_nodes_[i];
+            if( ws.visited( cells_[v] ) ) {
+                links.push_back( { v, ws.distance( cells_[v] ) } );
+            }
+        }
+      }
+      // appends the cells after <a> up to <b>, both ends are in one block or are neighbours
+  template<typename _Ty>
+      void refine( grid_workspace & ws, grid_map<_Ty> const& map, size_t a, size_t b, std::vector<grid_point> & path ) const
+      {
+        if( cluster_of( a ) != cluster_of( b ) ) {
+            path.push_back( map.point( b ) );
+            return;
+        }
+        detail::grid_bounded_bfs( ws, map, rect( cluster_of( a ) ), a, b );
+        const size_t first = path.size();
+        for( size_t c(b); c != a; c = ws.parent( c ) ) {
+            path.push_back( map.point( c ) );
+        }
+        std::reverse( path.begin() + first, path.end() );
+      }
+
+  template<typename _Ty>
+      void build( grid_map<_Ty> const& map )
+      {
+        const size_t blocks = clusters_x()*clusters_y();
+        std::vector<std::pair<uint32_t, uint32_t> > crossings;  // inter-block edges as cell pairs
+        // free runs along the border between the cells <a> and <a> + <step> walked by <along>
+        auto scan = [&]( size_t a, size_t step, size_t along, size_t length )
+        {
+          size_t run = 0;
+          for( size_t i(0); i <= length; i++ )
+          {
+              const size_t c = a + i*along;
+              if( i < length && map.free( c ) && map.free( c + step ) ) {
+                  run++;
+                  continue;
+              }
+              if( run != 0 ) {
+                  const size_t first = c - run*along, last = c - along;
+                  if( run < 6 ) {
+                      const size_t mid = first + ( run/2 )*along;
+                      crossings.push_back( { static_cast<uint32_t>( mid ), static_cast<uint32_t>( mid + step ) } );
+                  } else {
+                      crossings.push_back( { static_cast<uint32_t>( first ), static_cast<uint32_t>( first + step ) } );
+                      crossings.push_back( { static_cast<uint32_t>( last ), static_cast<uint32_t>( last + step ) } );
+                  }
+              }
+              run = 0;
+          }
+        };
+        for( size_t x( cluster_ ); x < width_; x += cluster_ ) {
+            for( size_t y(0); y < height_; y += cluster_ ) {
+                scan( y*width_ + x - 1, 1, width_, std::min<size_t>( cluster_, height_ - y ) );
+            }
+        }
+        for( size_t y( cluster_ ); y < height_; y += cluster_ ) {
+            for( size_t x(0); x < width_; x += cluster_ ) {
+                scan( ( y - 1 )*width_ + x, width_, 1, std::min<size_t>( cluster_, width_ - x ) );
+            }
+        }
+
+        for( auto const& p : crossings ) {
+            cells_.push_back( p.first );
+            cells_.push_back( p.second );
+        }
+        std::sort( cells_.begin(), cells_.end() );
+        cells_.erase( std::unique( cells_.begin(), cells_.end() ), cells_.end() );
+
+        cluster_offsets_.assign( blocks + 1, 0 );
+        for( auto c : cells_ ) {
+            cluster_offsets_[cluster_of( c ) + 1]++;
+        }
+        for( size_t k(0); k < blocks; k++ ) {
+            cluster_offsets_[k + 1] += cluster_offsets_[k];
+        }
+        cluster_nodes_.resize( cells_.size() );
+        std::vector<uint32_t> fill( cluster_offsets_.begin(), cluster_offsets_.end() - 1 );
+        for( size_t v(0); v < cells_.size(); v++ ) {
+            cluster_nodes_[fill[cluster_of( cells_[v] )]++] = static_cast<uint32_t>( v );
+        }
+
+        // the distances inside every block, one bounded search per entrance and blocks spread over the pool
+        std::vector<std::vector<uint32_t> > inner( blocks );  // ( from, to, cost ) triples
+        const size_t grain = std::max<size_t>( 1, blocks/( 8*num_threads() ) );
+        tvd::parallel_for( 0, blocks, grain, [&]( size_t first, size_t last )
+        {
+          auto & ws = grid_workspace::local();
+          for( size_t k(first); k < last; k++ ) {
+              for( size_t i( cluster_offsets_[k] ); i < cluster_offsets_[k + 1]; i++ )
+              {
+                  const uint32_t v = cluster_nodes_[i];
+                  detail::grid_bounded_bfs( ws, map, rect( k ), cells_[v] );
+                  for( size_t j( cluster_offsets_[k] ); j < cluster_offsets_[k + 1]; j++ ) {
+                      const uint32_t u = cluster_nodes_[j];
+                      if( u != v && ws.visited( cells_[u] ) ) {
+                          inner[k].insert( inner[k].end(), { v, u, ws.distance( cells_[u] ) } );
+                      }
+                  }
+              }
+          }
+        } );
+
+        edge_offsets_.assign( cells_.size() + 1, 0 );
+        for( auto const& p : crossings ) {
+            edge_offsets_[node_of( p.first ) + 1]++;
+            edge_offsets_[node_of( p.second ) + 1]++;
+        }
+        for( auto const& triples : inner ) {
+            for( size_t i(0); i < triples.size(); i += 3 ) {
+                edge_offsets_[triples[i] + 1]++;
+            }
+        }
+        for( size_t v(0); v < cells_.size(); v++ ) {
+            edge_offsets_[v + 1] += edge_offsets_[v];
+        }
+        edge_targets_.resize( edge_offsets_.back() );
+        edge_costs_.resize( edge_offsets_.back() );
+        fill.assign( edge_offsets_.begin(), edge_offsets_.end() - 1 );
+        auto add = [&]( size_t v, size_t u, uint32_t cost )
+        {
+          edge_targets_[fill[v]] = static_cast<uint32_t>( u );
+          edge_costs_[fill[v]++] = cost;
+        };
+        for( auto const& p : crossings ) {
+            const size_t a = node_of( p.first ), b = node_of( p.second );
+            add( a, b, 1 );
+            add( b, a, 1 );
+        }
+        for( auto const& triples : inner ) {
+            for( size_t i(0); i < triples.size(); i += 3 ) {
+                add( triples[i], triples[i + 1], triples[i + 2] );
+            }
+        }
+      }
+    };
+} // tvd
+#endif
@@ -0,0 +1,258 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the incremental grid planner
+#pragma once
+#ifndef TVD_GRID_PLANNER_HPP
+#define TVD_GRID_PLANNER_HPP
+
+#include "tvd/exception.hpp"
+#include "tvd/grid/search.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <vector>
+
+namespace tvd {
+// D* Lite over a grid_map : the search runs from the goal towards the start and keeps its state between plans,
+// so after update_cell() only the cells whose distance actually changed are expanded again.
+// the planner reads the cells through <map>, the caller changes them in place and reports every changed cell
+template<typename _Ty>
+    class grid_planner
+    {
+      static constexpr uint32_t inf = grid_workspace::none;
+
+      struct key_t
+      {
+        uint64_t k1;
+        uint32_t k2;
+
+        bool operator < ( key_t const& other ) const noexcept {
+          return k1 < other.k1 || ( k1 == other.k1 && k2 < other.k2 );
+        }
+
+        bool operator != ( key_t const& other ) const noexcept {
+          return k1 != other.k1 || k2 != other.k2;
+        }
+      };
+
+      struct entry
+      {
+        key_t    key;
+        uint32_t c;
+        // std::priority_queue keeps the largest on top
+        bool operator < ( entry const& other ) const noexcept {
+          return other.key < key;
+        }
+      };
+
+      grid_map<_Ty>               map_;
+      size_t                      start_;
+      size_t                      goal_;
+      uint64_t                    km_;
+      std::vector<uint32_t>       g_;
+      std::vector<uint32_t>       rhs_;
+      std::vector<key_t>          key_;
+      std::vector<uint8_t>        open_;
+      size_t                      open_cells_;  // the set flags of open_, the live entries of queue_
+      std::priority_queue<entry>  queue_;
+      size_t                      expanded_;
+public :
+      grid_planner( grid_map<_Ty> const& map, grid_point start, grid_point goal )
+        : map_( map )
+        , km_( 0 )
+        , g_( map.size(), inf )
+        , rhs_( map.size(), inf )
+        , key_( map.size() )
+        , open_( map.size(), 0 )
+        , open_cells_( 0 )
+        , expanded_( 0 )
+      {
+        if( !map.contains( start ) || !map.contains( goal ) ) {
+            throw TVD_EXCEPTION( "<grid_planner::grid_planner> : out of range" );
+        }
+        if( map.size() >= inf ) {
+            throw TVD_EXCEPTION( "<grid_planner::grid_planner> : grid is too large" );
+        }
+        start_ = map.index( start );
+        goal_  = map.index( goal );
+        update_vertex( goal_ );
+      }
+      // the agent moved, the costs already computed stay valid
+      void move_start( grid_point start )
+      {
+        if( !map_.contains( start ) ) {
+            throw TVD_EXCEPTION( "<grid_planner::move_start> : out of range" );
+        }
+        const size_t s = map_.index( start );
+        km_ += h( start_, s );
+        start_ = s;
+      }
+      // cell <p> was blocked or freed in the map
+      void update_cell( grid_point p )
+      {
+        if( !map_.contains( p ) ) {
+            throw TVD_EXCEPTION( "<grid_planner::update_cell> : out of range" );
+        }
+        const size_t c = map_.index( p );
+        update_vertex( c );
+        for_each_neighbour( c, [this]( size_t n ) { update_vertex( n ); } );
+      }
+
+      void update_cells( std::vector<grid_point> const& cells )
+      {
+        for( auto const& p : cells ) {
+            update_cell( p );
+        }
+      }
+      // repairs the search and writes the shortest path, start first; false when the goal is unreachable
+      bool plan( std::vector<grid_point> & path )
+      {
+        path.clear();
+        compute_shortest_path();
+        if( g_[start_] == inf || !map_.free( start_ ) ) {
+            return false;
+        }
+        size_t c = start_;
+        path.push_back( map_.point( c ) );
+        while( c != goal_ )
+        {
+            size_t   best   = c;
+            uint32_t best_g = inf;
+            for_each_neighbour( c, [&]( size_t n )
+            {
+              if( map_.free( n ) && g_[n] < best_g ) {
+                  best   = n;
+                  best_g = g_[n];
+              }
+            } );
+            if( best_g == inf || path.size() > map_.size() ) {
+                path.clear();
+                return false;
+            }
+            c = best;
+            path.push_back( map_.point( c ) );
+        }
+        return true;
+      }
+      // length of the shortest path in steps, grid_workspace::none when there is none
+      uint32_t distance()
+      {
+        compute_shortest_path();
+        return map_.free( start_ ) ? g_[start_] : inf;
+      }
+      // cells expanded since construction, the cost measure of the repairs
+      size_t expanded() const noexcept {
+        return expanded_;
+      }
+private :
+
+      size_t h( size_t a, size_t b ) const noexcept
+      {
+        const size_t ax = a%map_.width, ay = a/map_.width;
+        const size_t bx = b%map_.width, by = b/map_.width;
+        return ( ax > bx ? ax - bx : bx - ax ) + ( ay > by ? ay - by : by - ay );
+      }
+
+      key_t key( size_t c ) const noexcept
+      {
+        const uint32_t m = std::min( g_[c], rhs_[c] );
+        if( m == inf ) {
+            return { std::numeric_limits<uint64_t>::max(), inf };
+        }
+        return { m + h( start_, c ) + km_, m };
+      }
+      // in-bounds 4-neighbours, blocked ones included
+  template<class _FnTy>
+      void for_each_neighbour( size_t c, _FnTy && fn ) const
+      {
+        const size_t x = c%map_.width;
+        if( x + 1 < map_.width ) {
+            fn( c + 1 );
+        }
+        if( c + map_.width < map_.size() ) {
+            fn( c + map_.width );
+        }
+        if( x > 0 ) {
+            fn( c - 1 );
+        }
+        if( c >= map_.width ) {
+            fn( c - map_.width );
+        }
+      }
+
+      void update_vertex( size_t c )
+      {
+        if( c == goal_ ) {
+            rhs_[c] = map_.free( c ) ? 0 : inf;
+        } else if( !map_.free( c ) ) {
+            rhs_[c] = inf;
+        } else {
+            uint32_t rhs = inf;
+            for_each_neighbour( c, [&]( size_t n )
+            {
+              if( map_.free( n ) && g_[n] != inf ) {
+                  rhs = std::min( rhs, g_[n] + 1 );
+              }
+            } );
+            rhs_[c] = rhs;
+        }
+        if( g_[c] != rhs_[c] ) {
+            key_[c]  = key( c );
+            open_cells_ += !open_[c];
+            open_[c] = 1;
+            queue_.push( { key_[c], static_cast<uint32_t>( c ) } );
+        } else {
+            open_cells_ -= open_[c];
+            open_[c] = 0;
+        }
+      }
+      // queue entries are never removed in place, an entry whose key is no longer the cell's one is skipped
+      void compute_shortest_path()
+      {
+        while( !queue_.empty() )
+        {
+            const entry top = queue_.top();
+            if( !open_[top.c] || key_[top.c] != top.key ) {
+                queue_.pop();
+                continue;
+            }
+            if( !( top.key < key( start_ ) ) && rhs_[start_] == g_[start_] ) {
+                break;
+            }
+            queue_.pop();
+            const size_t u = top.c;
+            const key_t  k = key( u );
+            if( top.key < k ) {
+                key_[u] = k;
+                queue_.push( { k, top.c } );
+                continue;
+            }
+            expanded_++;
+            if( g_[u] > rhs_[u] ) {
+                g_[u]    = rhs_[u];
+                open_cells_ -= open_[u];
+                open_[u] = 0;
+            } else {
+                g_[u] = inf;
+                update_vertex( u );
+            }
+            for_each_neighbour( u, [this]( size_t n ) { update_vertex( n ); } );
+        }
+        if( queue_.size() > open_cells_ + map_.size() ) {
+            compact();
+        }
+      }
+      // drops the skipped entries once they outnumber the cells
+      void compact()
+      {
+        std::priority_queue<entry> queue;
+        for( size_t c(0); c < open_.size(); c++ ) {
+            if( open_[c] ) {
+                queue.push( { key_[c], static_cast<uint32_t>( c ) } );
+            }
+        }
+        queue_.swap( queue );
+      }
+    };
+} // tvd
+#endif
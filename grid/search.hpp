@@ -0,0 +1,498 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the grid path search
+#pragma once
+#ifndef TVD_GRID_SEARCH_HPP
+#define TVD_GRID_SEARCH_HPP
+
+#include "tvd/exception.hpp"
+#include "tvd/thread_pool.hpp"
+#include "tvd/matrix/matrix_view.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace tvd {
+
+    struct grid_point
+    {
+      size_t x;
+      size_t y;
+
+      bool operator == ( grid_point const& other ) const noexcept {
+        return x == other.x && y == other.y;
+      }
+
+      bool operator != ( grid_point const& other ) const noexcept {
+        return !( *this == other );
+      }
+    };
+
+    enum class grid_method
+    {
+      bfs,            // wavefront from the source
+      bidirectional,  // wavefronts from both ends, the smaller one is expanded
+      astar,          // best-first with the manhattan distance to the target
+      parallel        // wavefront from the source, every level split over the thread pool
+    };
+// occupancy grid over row-major cells, y is the row and x the column; a cell is free when it equals <blank>
+template<typename _Ty>
+    struct grid_map
+    {
+      const _Ty *cells;
+      size_t     width;
+      size_t     height;
+      _Ty        blank;
+
+      grid_map( const _Ty *cells, size_t width, size_t height, _Ty blank ) noexcept
+        : cells( cells )
+        , width( width )
+        , height( height )
+        , blank( blank )
+      {
+      }
+
+  template<class _ElemTraitsTy>
+      grid_map( matrix_view<_Ty, _ElemTraitsTy> const& map, _Ty blank ) noexcept
+        : grid_map( map.data(), map.csize(), map.size(), blank )
+      {
+      }
+
+      size_t size() const noexcept {
+        return width*height;
+      }
+
+      bool free( size_t c ) const noexcept {
+        return cells[c] == blank;
+      }
+
+      bool contains( grid_point const& p ) const noexcept {
+        return p.x < width && p.y < height;
+      }
+
+      size_t index( grid_point const& p ) const noexcept {
+        return p.y*width + p.x;
+      }
+
+      grid_point point( size_t c ) const noexcept {
+        return { c%width, c/width };
+      }
+    };
+
+    namespace detail {
+      // fifo of cell indices over a power of two ring, grows only when the frontier outgrows it
+      class grid_ring
+      {
+        std::vector<uint32_t> ring_;
+        size_t                head_;
+        size_t                size_;
+public :
+        grid_ring()
+          : ring_( 1024 )
+          , head_( 0 )
+          , size_( 0 )
+        {
+        }
+
+        void clear() noexcept {
+          head_ = size_ = 0;
+        }
+
+        bool empty() const noexcept {
+          return size_ == 0;
+        }
+
+        size_t size() const noexcept {
+          return size_;
+        }
+
+        void push( uint32_t c )
+        {
+          if( size_ == ring_.size() ) {
+              grow();
+          }
+          ring_[( head_ + size_ )&( ring_.size() - 1 )] = c;
+          size_++;
+        }
+
+        uint32_t pop() noexcept
+        {
+          const uint32_t c = ring_[head_];
+          head_ = ( head_ + 1 )&( ring_.size() - 1 );
+          size_--;
+          return c;
+        }
+private :
+
+        void grow()
+        {
+          std::vector<uint32_t> ring( 2*ring_.size() );
+          for( size_t i(0); i < size_; i++ ) {
+              ring[i] = ring_[( head_ + i )&( ring_.size() - 1 )];
+          }
+          ring_.swap( ring );
+          head_ = 0;
+        }
+      };
+    } // detail
+// buffers of a search, sized to the largest grid seen; the visited marks are epoch stamps,
+// so starting a query costs nothing however large the grid is. the stamps are atomic for the parallel
+// search only, the relaxed loads and stores of the serial ones are plain moves
+    class grid_workspace
+    {
+public :
+      static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+private :
+      std::unique_ptr<std::atomic<uint32_t>[]> stamp_;
+      size_t                                   cells_;
+      std::vector<uint32_t>                    dist_;
+      std::vector<uint32_t>                    parent_;
+      uint32_t                                 epoch_;
+      detail::grid_ring                        ring_[2];
+      std::vector<uint32_t>                    open_[2];
+      std::vector<std::vector<uint32_t> >      buckets_;
+public :
+      grid_workspace()
+        : cells_( 0 )
+        , epoch_( 0 )
+      {
+      }
+      // workspace of the calling thread
+      static grid_workspace & local()
+      {
+        thread_local grid_workspace workspace;
+        return workspace;
+      }
+      // starts a query over <cells> cells, two stamps are taken : one per search side
+      void prepare( size_t cells )
+      {
+        if( cells >= none ) {
+            throw TVD_EXCEPTION( "<grid_workspace::prepare> : grid is too large" );
+        }
+        if( cells_ < cells ) {
+            stamp_ = std::make_unique<std::atomic<uint32_t>[]>( cells );
+            cells_ = cells;
+            dist_.resize( cells );
+            parent_.resize( cells );
+        }
+        if( epoch_ >= none - 4 ) {
+            for( size_t c(0); c < cells_; c++ ) {
+                stamp_[c].store( 0, std::memory_order_relaxed );
+            }
+            epoch_ = 0;
+        }
+        epoch_ += 2;
+        for( size_t side(0); side < 2; side++ ) {
+            ring_[side].clear();
+            open_[side].clear();
+        }
+      }
+      // reached in this query from the side <side>, 0 is the source and 1 the target
+      bool visited( size_t c, uint32_t side = 0 ) const noexcept {
+        return stamp_[c].load( std::memory_order_relaxed ) == epoch_ + side;
+      }
+      // reached in this query from any side
+      bool seen( size_t c ) const noexcept {
+        return stamp_[c].load( std::memory_order_relaxed ) >= epoch_;
+      }
+
+      void visit( size_t c, uint32_t side, uint32_t dist, uint32_t parent ) noexcept
+      {
+        stamp_[c].store( epoch_ + side, std::memory_order_relaxed );
+        dist_[c]   = dist;
+        parent_[c] = static_cast<uint32_t>( parent );
+      }
+      // visit() from the source side racing with other threads, only the thread that stamps <c> first
+      // writes its distance and parent and gets true
+      bool claim( size_t c, uint32_t dist, uint32_t parent ) noexcept
+      {
+        uint32_t stamp = stamp_[c].load( std::memory_order_relaxed );
+        while( stamp < epoch_ )
+        {
+            if( stamp_[c].compare_exchange_weak( stamp, epoch_, std::memory_order_relaxed ) ) {
+                dist_[c]   = dist;
+                parent_[c] = parent;
+                return true;
+            }
+        }
+        return false;
+      }
+      // marks an expanded cell of a one-sided search, its distance and parent are kept
+      void close( size_t c ) noexcept {
+        stamp_[c].store( epoch_ + 1, std::memory_order_relaxed );
+      }
+      // distance from the source of the side that reached <c>
+      uint32_t distance( size_t c ) const noexcept {
+        return dist_[c];
+      }
+      // previous cell towards that source, <none> at the source
+      uint32_t parent( size_t c ) const noexcept {
+        return parent_[c];
+      }
+
+      detail::grid_ring & ring( size_t side ) noexcept {
+        return ring_[side];
+      }
+
+      std::vector<uint32_t> & open( size_t bucket ) noexcept {
+        return open_[bucket];
+      }
+      // per-chunk output of the parallel search, at least <chunks> of them
+      std::vector<std::vector<uint32_t> > & buckets( size_t chunks )
+      {
+        if( buckets_.size() < chunks ) {
+            buckets_.resize( chunks );
+        }
+        return buckets_;
+      }
+    };
+
+    namespace detail {
+      // calls fn( neighbour ) for the free 4-neighbours of <c>
+  template<
+      typename _Ty,
+      class _FnTy>
+      inline void grid_neighbours( grid_map<_Ty> const& map, size_t c, _FnTy && fn )
+      {
+        const size_t x = c%map.width;
+        if( x + 1 < map.width && map.free( c + 1 ) ) {
+            fn( c + 1 );
+        }
+        if( c + map.width < map.size() && map.free( c + map.width ) ) {
+            fn( c + map.width );
+        }
+        if( x > 0 && map.free( c - 1 ) ) {
+            fn( c - 1 );
+        }
+        if( c >= map.width && map.free( c - map.width ) ) {
+            fn( c - map.width );
+        }
+      }
+      // appends the back-pointer chain ending at <c>, source first
+  template<typename _Ty>
+      void grid_trace( grid_workspace const& ws, grid_map<_Ty> const& map, size_t c, std::vector<grid_point> & path )
+      {
+        const size_t first = path.size();
+        for( ; c != grid_workspace::none; c = ws.parent( c ) ) {
+            path.push_back( map.point( c ) );
+        }
+        std::reverse( path.begin() + first, path.end() );
+      }
+      // every cell enters the ring once, O(cells)
+  template<typename _Ty>
+      bool grid_bfs( grid_workspace & ws, grid_map<_Ty> const& map, size_t s, size_t t, std::vector<grid_point> & path )
+      {
+        auto & ring = ws.ring( 0 );
+        ws.visit( s, 0, 0, grid_workspace::none );
+        ring.push( static_cast<uint32_t>( s ) );
+        while( !ring.empty() )
+        {
+            const size_t c = ring.pop();
+            if( c == t ) {
+                grid_trace( ws, map, t, path );
+                return true;
+            }
+            const uint32_t d = ws.distance( c ) + 1;
+            grid_neighbours( map, c, [&]( size_t n )
+            {
+              if( !ws.seen( n ) ) {
+                  ws.visit( n, 0, d, static_cast<uint32_t>( c ) );
+                  ring.push( static_cast<uint32_t>( n ) );
+              }
+            } );
+        }
+        return false;
+      }
+      // whole levels of the smaller wavefront are expanded, the shortest meeting found
+      // during the first level that touches the other side is the shortest path
+  template<typename _Ty>
+      bool grid_bidirectional( grid_workspace & ws, grid_map<_Ty> const& map, size_t s, size_t t, std::vector<grid_point> & path )
+      {
+        ws.visit( s, 0, 0, grid_workspace::none );
+        ws.visit( t, 1, 0, grid_workspace::none );
+        ws.ring( 0 ).push( static_cast<uint32_t>( s ) );
+        ws.ring( 1 ).push( static_cast<uint32_t>( t ) );
+
+        while( !ws.ring( 0 ).empty() && !ws.ring( 1 ).empty() )
+        {
+            const uint32_t side  = ws.ring( 0 ).size() <= ws.ring( 1 ).size() ? 0 : 1;
+            auto &         ring  = ws.ring( side );
+            uint32_t       best  = grid_workspace::none;
+            size_t         meet[2];
+
+            for( size_t level( ring.size() ); level != 0; level-- )
+            {
+                const size_t c = ring.pop();
+                const uint32_t d = ws.distance( c ) + 1;
+                grid_neighbours( map, c, [&]( size_t n )
+                {
+                  if( ws.visited( n, side ) ) {
+                      return;
+                  }
+                  if( ws.visited( n, 1 - side ) ) {
+                      if( d + ws.distance( n ) < best ) {
+                          best = d + ws.distance( n );
+                          meet[side]     = c;
+                          meet[1 - side] = n;
+                      }
+                      return;
+                  }
+                  ws.visit( n, side, d, static_cast<uint32_t>( c ) );
+                  ring.push( static_cast<uint32_t>( n ) );
+                } );
+            }
+            if( best != grid_workspace::none )
+            {
+                grid_trace( ws, map, meet[0], path );
+                for( size_t c( meet[1] ); c != grid_workspace::none; c = ws.parent( c ) ) {
+                    path.push_back( map.point( c ) );
+                }
+                return true;
+            }
+        }
+        return false;
+      }
+      // unit costs and a consistent heuristic keep f = g + h at <f> or <f> + 2 for every new cell,
+      // so two lifo buckets replace the priority queue; stale entries are skipped once closed
+  template<typename _Ty>
+      bool grid_astar( grid_workspace & ws, grid_map<_Ty> const& map, size_t s, size_t t, std::vector<grid_point> & path )
+      {
+        const size_t tx = t%map.width, ty = t/map.width;
+        auto h = [&]( size_t c ) -> size_t
+        {
+          const size_t x = c%map.width, y = c/map.width;
+          return ( x > tx ? x - tx : tx - x ) + ( y > ty ? y - ty : ty - y );
+        };
+
+        std::vector<uint32_t> * current = &ws.open( 0 );
+        std::vector<uint32_t> * next    = &ws.open( 1 );
+        ws.visit( s, 0, 0, grid_workspace::none );
+        current->push_back( static_cast<uint32_t>( s ) );
+
+        for( ;; )
+        {
+            if( current->empty() ) {
+                if( next->empty() ) {
+                    return false;
+                }
+                std::swap( current, next );
+                continue;
+            }
+            const size_t c = current->back();
+            current->pop_back();
+            if( ws.visited( c, 1 ) ) {
+                continue;
+            }
+            if( c == t ) {
+                grid_trace( ws, map, t, path );
+                return true;
+            }
+            ws.close( c );
+            const uint32_t d  = ws.distance( c ) + 1;
+            const size_t   hc = h( c );
+            grid_neighbours( map, c, [&]( size_t n )
+            {
+              if( ws.visited( n, 1 ) || ( ws.visited( n, 0 ) && ws.distance( n ) <= d ) ) {
+                  return;
+              }
+              ws.visit( n, 0, d, static_cast<uint32_t>( c ) );
+              ( h( n ) < hc ? current : next )->push_back( static_cast<uint32_t>( n ) );
+            } );
+        }
+      }
+      // level-synchronous wavefront : the cells of a level are split into chunks over the thread pool, every chunk
+      // claims the unseen neighbours into its own bucket and the buckets are joined in chunk order between the levels.
+      // a cell is claimed once and at its bfs level, so the path is as short as the serial one; small levels run inline
+  template<typename _Ty>
+      bool grid_parallel_bfs( grid_workspace & ws, grid_map<_Ty> const& map, size_t s, size_t t, std::vector<grid_point> & path )
+      {
+        constexpr size_t min_grain = 4096;
+        std::vector<uint32_t> * current = &ws.open( 0 );
+        std::vector<uint32_t> * next    = &ws.open( 1 );
+        ws.visit( s, 0, 0, grid_workspace::none );
+        current->push_back( static_cast<uint32_t>( s ) );
+
+        const size_t threads = num_threads();
+        for( uint32_t d(1); !current->empty(); d++ )
+        {
+            const size_t cells  = current->size();
+            const size_t grain  = std::max( min_grain, cells/( 4*threads ) );
+            const size_t chunks = ( cells + grain - 1 )/grain;
+            auto & buckets = ws.buckets( chunks );
+            tvd::parallel_for( 0, cells, grain, [&]( size_t first, size_t last )
+            {
+              auto & bucket = buckets[first/grain];
+              bucket.clear();
+              for( size_t i(first); i < last; i++ )
+              {
+                  const uint32_t c = ( *current )[i];
+                  grid_neighbours( map, c, [&]( size_t n )
+                  {
+                    if( !ws.seen( n ) && ws.claim( n, d, c ) ) {
+                        bucket.push_back( static_cast<uint32_t>( n ) );
+                    }
+                  } );
+              }
+            } );
+            if( ws.seen( t ) ) {
+                grid_trace( ws, map, t, path );
+                return true;
+            }
+            next->clear();
+            for( size_t k(0); k < chunks; k++ ) {
+                next->insert( next->end(), buckets[k].begin(), buckets[k].end() );
+            }
+            std::swap( current, next );
+        }
+        return false;
+      }
+    } // detail
+// shortest 4-connected path between two free cells, <path> gets it source first;
+// false when the cells are not connected or one of them is blocked. grid_method::parallel holds <ws>
+// across the parallel_for of every level, nothing else may use it meanwhile; grid_workspace::local()
+// is swapped for a leased workspace, since the pool runs other searches on the waiting thread
+template<typename _Ty>
+    bool grid_find_path( grid_workspace & ws, grid_map<_Ty> const& map, grid_point from, grid_point to,
+                         std::vector<grid_point> & path, grid_method method = grid_method::bfs )
+    {
+      if( method == grid_method::parallel && &ws == &grid_workspace::local() ) {
+          local_lease<grid_workspace> lease;
+          return grid_find_path( *lease, map, from, to, path, method );
+      }
+      path.clear();
+      if( !map.contains( from ) || !map.contains( to ) ) {
+          throw TVD_EXCEPTION( "<tvd::grid_find_path> : out of range" );
+      }
+      const size_t s = map.index( from );
+      const size_t t = map.index( to );
+      if( !map.free( s ) || !map.free( t ) ) {
+          return false;
+      }
+      if( s == t ) {
+          path.push_back( from );
+          return true;
+      }
+      ws.prepare( map.size() );
+      switch( method )
+      {
+        case grid_method::bidirectional :
+          return detail::grid_bidirectional( ws, map, s, t, path );
+        case grid_method::astar :
+          return detail::grid_astar( ws, map, s, t, path );
+        case grid_method::parallel :
+          return detail::grid_parallel_bfs( ws, map, s, t, path );
+        default :
+          return detail::grid_bfs( ws, map, s, t, path );
+      }
+    }
+// same over the workspace of the calling thread
+template<typename _Ty>
+    bool grid_find_path( grid_map<_Ty> const& map, grid_point from, grid_point to,
+                         std::vector<grid_point> & path, grid_method method = grid_method::bfs ) {
+      return grid_find_path( grid_workspace::local(), map, from, to, path, method );
+    }
+} // tvd
+#endif
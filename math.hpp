@@ -6,8 +6,13 @@
 
 #include "tvd/matrix/matrix.hpp"
 #include "tvd/matrix/matrix_view.hpp"
+#include "tvd/matrix/strided_view.hpp"
+#include "tvd/matrix/small_matrix.hpp"
+#include "tvd/matrix/lu.hpp"
 #include "tvd/math_defines.hpp"
 #include "tvd/algorithm.hpp"
+#include "tvd/grid/batch.hpp"
+#include "tvd/grid/search.hpp"
 
 #include <cmath>
 
@@ -22,110 +27,70 @@
 #endif
 
 namespace tvd {
-//
+
+    namespace detail {
+      // rows {x, y, 1} of <path> from its last point to its first
+      inline matrix_3xn_t<size_t> lee_neumann_rows( std::vector<grid_point> const& path )
+      {
+        matrix_3xn_t<size_t> way( path.size() );
+        for( size_t i(0); i < path.size(); i++ )
+        {
+            auto const& p = path[path.size() - 1 - i];
+            auto        r = way[i];
+            r[0] = p.x;
+            r[1] = p.y;
+            r[2] = 1;
+        }
+        return way;
+      }
+    } // detail
+// shortest 4-connected path over the free cells of <map> (equal to <blank>), rows {x, y, 1} from the target
+// back to the source; the search runs in O(cells) on the calling thread's grid_workspace, see grid/search.hpp
 template<typename _Ty,
     is_arithmetic_t<_Ty> = true >
     TVD_OPTIONAL( detail::matrix_3xn_t<size_t> ) lee_neumann( matrix_view<_Ty> const& map,
                                                               size_t x_from, size_t y_from,
                                                               size_t x_to,   size_t y_to,
-                                                              _Ty blank                     )
+                                                              _Ty blank,
+                                                              grid_method method = grid_method::bfs )
     {
       if( map.size() <= y_from || map.csize() <= x_from || map.size() <= y_to || map.csize() <= x_to ) {
           throw TVD_EXCEPTION("<tvd::lee_neumann> : out of range");
       }
-      if( map[y_from][x_from] != blank || map[y_to][x_to] != blank ) {
+
+      // held across the search : the parallel method waits in parallel_for, where this thread may run another query
+      local_lease<std::vector<grid_point> > path;
+      if( !grid_find_path( grid_map<_Ty>( map, blank ), { x_from, y_from }, { x_to, y_to }, *path, method ) ) {
           return TVD_NULLOPT;
       }
+      return detail::lee_neumann_rows( *path );
+    }
+// every (from, to) query over the same map, run concurrently on the thread pool; results in input order
+template<typename _Ty,
+    is_arithmetic_t<_Ty> = true >
+    std::vector<TVD_OPTIONAL( detail::matrix_3xn_t<size_t> )> lee_neumann( matrix_view<_Ty> const& map,
+                                                                           std::vector<grid_query> const& queries,
+                                                                           _Ty blank,
+                                                                           grid_method method = grid_method::bfs )
+    {
+      // held across grid_find_paths : a task stolen while it waits may run another batch on this thread
+      local_lease<std::vector<std::vector<grid_point> > > paths;
+      grid_find_paths( grid_map<_Ty>( map, blank ), queries, *paths, method );
 
-      using matrix_3xn_t = detail::matrix_3xn_t<size_t>;
-
-      matrix_3xn_t    way  = { y_from, x_from, 0 };
-      const int       dx[] = { 1, 0, -1,  0 };
-      const int       dy[] = { 0, 1,  0, -1 };
-      bool            stop;
-
-      auto wave_propagation = [&map,  &blank,
-                               &way,  &stop,
-                               &dx,   &dy,
-                               &x_to, &y_to  ]( const auto y, const auto x, const auto & d ) -> int
-      {
-        for( size_t i(0); i < 4; i++ )
-        {
-            int iy = y + dy[i], ix = x + dx[i];
-            if ( (map.size() > iy || map.csize() > ix) &&
-                  iy          >= 0                     &&
-                  ix          >= 0                     &&
-                  map[iy][ix] == blank                    )
-            {
-                if( insert_if( way, { iy, ix, d + 1 },
-                    [&ix, &iy]( auto const& v ) {
-                    return !(v[0] == iy && v[1] == ix);
-                }) )
-                {
-                    if( iy == y_to && ix == x_to) {
-                        return std::size(way) - 1;
-                    }
-                    stop = false;
-                }
-            }
-        }
-        return 0;
-      };
-
-      int y_end(0);
-      size_t d(0);
-
-      do {
-          stop = true;
-          for( size_t i(0); i < std::size(way); i++ )
-          {
-              if( way[i][2] == d ) {
-                  y_end = wave_propagation( way[i][0], way[i][1], d );
-              }
-              if( y_end ) {
-                  break;
-              }
-          }
-          d++;
-      } while( !stop );
-
-      if( !y_end ) return TVD_NULLOPT;
-
-      auto neighbour = [&dx, &dy]( auto const& curr_v, auto const& last_v )
+      std::vector<TVD_OPTIONAL( detail::matrix_3xn_t<size_t> )> ways;
+      ways.reserve( queries.size() );
+      for( auto const& path : *paths )
       {
-        return ( ( last_v[0] - 1 == curr_v[0]   || last_v[0] + 1 == curr_v[0] ) &&
-                 ( last_v[1]     == curr_v[1] ) ||
-                 ( last_v[1] - 1 == curr_v[1]   || last_v[1] + 1 == curr_v[1] ) &&
-                 ( last_v[0]     == curr_v[0] )                                    );
-      };
-
-      size_t x( x_to ), y( y_to );
-      decltype( way[0] ) last_v( way[y_end] );
-      d = way[y_end][2] - 1;
-      y_end--;
-      matrix_3xn_t min_w;
-      min_w.push_back( { x_to, y_to, 1 } );
-
-      while( d > 0 ) {
-          auto l = d;
-          for( size_t i(y_end); i != 0; i-- )
-          {
-              if( way[i][2] == d && neighbour(way[i], last_v) ) {
-                  min_w.push_back( { way[i][1], way[i][0], 1 } );
-                  last_v = way[i];
-                  d--;
-                  break;
-              }
-          }
-          if( l == d ) {
-              return TVD_NULLOPT;
+          if( path.empty() ) {
+              ways.push_back( TVD_NULLOPT );
+          } else {
+              ways.push_back( detail::lee_neumann_rows( path ) );
           }
       }
-
-      min_w.push_back( { x_from, y_from, 1 } );
-      return min_w;
+      return ways;
     }
-// LU
+// LU : A = L*U with U upper triangular and L the row permutation of a unit lower triangular matrix
+// taken by the partial pivoting; lu_factor() keeps both in one matrix and the permutation apart
 template<typename _MatrixTy,
     is_arithmetic_t<typename _MatrixTy::type_t> = true >
     std::pair<_MatrixTy, _MatrixTy> LU( _MatrixTy const& A )
@@ -137,28 +102,28 @@ template<typename _MatrixTy,
 
       _MatrixTy L( size );
       _MatrixTy U = A;
+      std::vector<size_t> perm( size );
+      detail::lu_factor( size, U.data(), size, perm.data() );
 
-      for(size_t i(0); i < size; i++)
-          for(size_t j(i); j < size; j++)
-              L[j][i] = U[j][i]/U[i][i];
-
-      for(size_t k(1); k < size; k++)
+      auto u = U.data();
+      auto l = L.data();
+      for( size_t i(0); i < size; i++ )
       {
-          for(size_t i(k - 1); i < size; i++)
-              for(size_t j(i); j < size; j++)
-                  L[j][i] = U[j][i]/U[i][i];
-          for(size_t i(k); i < size; i++)
-              for(size_t j(k - 1); j < size; j++)
-                  U[i][j] = U[i][j] - L[i][k - 1]*U[k - 1][j];
+          for( size_t j(0); j < i; j++ ) {
+              l[perm[i]*size + j] = u[i*size + j];
+              u[i*size + j] = 0;
+          }
+          l[perm[i]*size + i] = 1;
       }
       return { L, U };
     }
 
+// transforms build a 3x3 small matrix on the stack and multiply every row by it in place
 template<typename _Ty,
     is_arithmetic_t<_Ty> = true >
     void move( detail::matrix_3xn_t<_Ty> & m_res, _Ty x0, _Ty y0, _Ty x1, _Ty y1 )
     {
-      detail::matrix_3xn_t<_Ty> t_tr
+      const detail::small_matrix3_t<_Ty> t_tr
       {   1,          0,       0,
           0,          1,       0,
           x1 - x0,    y1 - y0, 1   };
@@ -169,7 +134,7 @@ template<typename _Ty,
 template<typename _Ty,
     is_arithmetic_t<_Ty> = true >
     void move( detail::matrix_3xn_t<_Ty> & m_res, _Ty x, _Ty y ) {
-      move( m_res, 0, 0, x, y );
+      move( m_res, _Ty(0), _Ty(0), x, y );
     }
 
 template<typename _Ty,
@@ -179,7 +144,7 @@ template<typename _Ty,
       _Ty m = m_res[0][0]*(1 - k_x);
       _Ty l = m_res[0][1]*(1 - k_y);
 
-      detail::matrix_3xn_t<_Ty> t_scl
+      const detail::small_matrix3_t<_Ty> t_scl
       {   k_x, 0,   0,
           0,   k_y, 0,
           m,   l,   1   };
@@ -194,7 +159,7 @@ template<typename _Ty,
       _Ty sin = std::sin(r_ang);
       _Ty cos = std::cos(r_ang);
 
-      detail::matrix_3xn_t<_Ty> t_rot
+      const detail::small_matrix3_t<_Ty> t_rot
       {   cos,                 sin,                 0,
          -sin,                 cos,                 0,
           x*(1 - cos) + y*sin, y*(1 - cos) - x*sin, 1   };
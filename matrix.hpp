@@ -2,4 +2,5 @@
 #ifndef TVD_MATRIX_HPP
 #define TVD_MATRIX_HPP
 # include "tvd/matrix/io.hpp"
+# include "tvd/matrix/binary_io.hpp"
 #endif
\ No newline at end of file
@@ -0,0 +1,372 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the binary matrix files
+#pragma once
+#ifndef TVD_MATRIX_BINARY_IO_HPP
+#define TVD_MATRIX_BINARY_IO_HPP
+
+#include "tvd/exception.hpp"
+#include "tvd/matrix/matrix.hpp"
+#include "tvd/matrix/matrix_view.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#if defined(_WIN32)
+# ifndef NOMINMAX
+#  define NOMINMAX
+# endif
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace tvd {
+// file layout : this 64-byte header, zero padding up to <data_offset>, then rows*col_size elements row by
+// row in the byte order of the writer. the data starts on a multiple of <alignment> from the file start,
+// so a mapping, which starts on a page, hands it out aligned
+struct matrix_file_header
+{
+  static constexpr uint32_t format_version = 1;
+  // written as is, reads back as 0x04030201 on a host of the other byte order
+  static constexpr uint32_t byte_order_mark = 0x01020304;
+
+  char     magic[4];      // "TVDM"
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t type;          // see matrix_file_type_v
+  uint64_t col_size;
+  uint64_t rows;
+  uint64_t data_offset;
+  uint64_t alignment;
+  uint64_t checksum;      // of the data bytes, see detail::matrix_file_checksum
+  uint64_t reserved;
+};
+
+static_assert( sizeof(matrix_file_header) == 64, "< tvd::matrix_file_header > : the header must stay 64 bytes" );
+// element type tag : the size in bytes, 0x100 for floating point, 0x200 for signed
+template<typename _Ty>
+    inline constexpr uint32_t matrix_file_type_v = uint32_t( sizeof(_Ty) )
+      | ( std::is_floating_point_v<_Ty> ? 0x100u : 0u )
+      | ( std::is_signed_v<_Ty> ? 0x200u : 0u );
+
+    namespace detail {
+      // FNV-1a over 8-byte words in four interleaved lanes, so the multiplies do not wait on each other;
+      // the tail bytes go to the first lane
+      inline uint64_t matrix_file_checksum( const void *data, size_t bytes ) noexcept
+      {
+        constexpr uint64_t prime = 1099511628211ull;
+        uint64_t lane[4] = { 14695981039346656037ull, 14695981039346656037ull,
+                             14695981039346656037ull, 14695981039346656037ull };
+        const auto *p = static_cast<const unsigned char*>( data );
+        const size_t words = bytes/8;
+        size_t w(0);
+        for( ; w + 4 <= words; w += 4 ) {
+            for( size_t l(0); l < 4; l++ )
+            {
+                uint64_t x;
+                std::memcpy( &x, p + ( w + l )*8, 8 );
+                lane[l] = ( lane[l] ^ x )*prime;
+            }
+        }
+        for( ; w < words; w++ )
+        {
+            uint64_t x;
+            std::memcpy( &x, p + w*8, 8 );
+            lane[w%4] = ( lane[w%4] ^ x )*prime;
+        }
+        for( size_t b( words*8 ); b < bytes; b++ ) {
+            lane[0] = ( lane[0] ^ p[b] )*prime;
+        }
+        uint64_t hash = 14695981039346656037ull;
+        for( auto l : { lane[0], lane[1], lane[2], lane[3], uint64_t( bytes ) } ) {
+            hash = ( hash ^ l )*prime;
+        }
+        return hash;
+      }
+
+  template<typename _Ty>
+      void write_matrix_file( std::ostream & o, const _Ty *data, size_t rows, size_t col_size, size_t alignment )
+      {
+        static_assert( std::is_arithmetic_v<_Ty>, "< tvd::save_matrix > : <_Ty> must be arithmetic" );
+        if( alignment < alignof(_Ty) || ( alignment & ( alignment - 1 ) ) != 0 ) {
+            throw TVD_EXCEPTION( "<tvd::save_matrix> : <alignment> must be a power of two not less than alignof(_Ty)" );
+        }
+        const size_t bytes = rows*col_size*sizeof(_Ty);
+        matrix_file_header header{};
+        std::memcpy( header.magic, "TVDM", 4 );
+        header.version     = matrix_file_header::format_version;
+        header.byte_order  = matrix_file_header::byte_order_mark;
+        header.type        = matrix_file_type_v<_Ty>;
+        header.col_size    = col_size;
+        header.rows        = rows;
+        header.alignment   = alignment;
+        header.data_offset = ( sizeof(matrix_file_header) + alignment - 1 )/alignment*alignment;
+        header.checksum    = matrix_file_checksum( data, bytes );
+        o.write( reinterpret_cast<const char*>( &header ), sizeof(header) );
+        for( size_t pad( sizeof(header) ); pad < header.data_offset; pad++ ) {
+            o.put( 0 );
+        }
+        o.write( reinterpret_cast<const char*>( data ), static_cast<std::streamsize>( bytes ) );
+        if( !o ) {
+            throw TVD_EXCEPTION( "<tvd::save_matrix> : write failed" );
+        }
+      }
+      // throws unless <header> describes <_Ty> elements of this host whose data fits in <file_size> bytes
+  template<typename _Ty>
+      void check_matrix_file( matrix_file_header const& header, uint64_t file_size, const char *fn )
+      {
+        if( !std::equal( header.magic, header.magic + 4, "TVDM" ) || header.version != matrix_file_header::format_version ) {
+            throw TVD_EXCEPTION( std::string( fn ) + " : not a matrix file" );
+        }
+        if( header.byte_order != matrix_file_header::byte_order_mark ) {
+            throw TVD_EXCEPTION( std::string( fn ) + " : the file has the other byte order" );
+        }
+        if( header.type != matrix_file_type_v<_Ty> ) {
+            throw TVD_EXCEPTION( std::string( fn ) + " : the file holds another element type" );
+        }
+        if( header.alignment == 0 || header.data_offset%header.alignment != 0 || header.data_offset%alignof(_Ty) != 0
+            || header.data_offset < sizeof(matrix_file_header) ) {
+            throw TVD_EXCEPTION( std::string( fn ) + " : bad data offset" );
+        }
+        if( header.col_size != 0 && header.rows > ( UINT64_MAX/sizeof(_Ty) )/header.col_size ) {
+            throw TVD_EXCEPTION( std::string( fn ) + " : bad shape" );
+        }
+        if( file_size < header.data_offset || file_size - header.data_offset < header.rows*header.col_size*sizeof(_Ty) ) {
+            throw TVD_EXCEPTION( std::string( fn ) + " : truncated file" );
+        }
+      }
+    } // detail
+// writes <m> with its data aligned to <alignment> bytes in the file, 64 keeps a mapped view on cache lines
+template<
+    typename _Ty,
+    size_t col_size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    void save_matrix( std::ostream & o, matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> const& m, size_t alignment = 64 ) {
+      detail::write_matrix_file( o, m.data(), m.size(), col_size, alignment );
+    }
+
+template<typename _Ty>
+    void save_matrix( std::ostream & o, matrix_view<_Ty> const& m, size_t alignment = 64 ) {
+      detail::write_matrix_file( o, m.data(), m.size(), m.csize(), alignment );
+    }
+
+template<class _MatrixTy>
+    void save_matrix( std::string const& path, _MatrixTy const& m, size_t alignment = 64 )
+    {
+      std::ofstream o( path, std::ios::binary | std::ios::trunc );
+      if( !o ) {
+          throw TVD_EXCEPTION( "<tvd::save_matrix> : cannot open " + path );
+      }
+      save_matrix( o, m, alignment );
+    }
+// reads a file written by save_matrix into a new matrix and checks the checksum; for a seekable stream the
+// shape is checked against the bytes left in it before the matrix is allocated
+template<
+    typename _Ty,
+    size_t col_size>
+    matrix<_Ty, col_size> load_matrix( std::istream & i )
+    {
+      uint64_t file_size = UINT64_MAX;
+      const auto start = i.tellg();
+      if( start != std::istream::pos_type( -1 ) && i.seekg( 0, std::ios::end ) ) {
+          file_size = static_cast<uint64_t>( i.tellg() - start );
+          i.seekg( start );
+      }
+      i.clear();
+      matrix_file_header header{};
+      i.read( reinterpret_cast<char*>( &header ), sizeof(header) );
+      if( !i ) {
+          throw TVD_EXCEPTION( "<tvd::load_matrix> : not a matrix file" );
+      }
+      detail::check_matrix_file<_Ty>( header, file_size, "<tvd::load_matrix>" );
+      if( header.col_size != col_size ) {
+          throw TVD_EXCEPTION( "<tvd::load_matrix> : <col_size> differs from the file" );
+      }
+      i.ignore( static_cast<std::streamsize>( header.data_offset - sizeof(header) ) );
+      matrix<_Ty, col_size> m( header.rows );
+      const size_t bytes = header.rows*col_size*sizeof(_Ty);
+      i.read( reinterpret_cast<char*>( m.data() ), static_cast<std::streamsize>( bytes ) );
+      if( !i ) {
+          throw TVD_EXCEPTION( "<tvd::load_matrix> : truncated file" );
+      }
+      if( detail::matrix_file_checksum( m.data(), bytes ) != header.checksum ) {
+          throw TVD_EXCEPTION( "<tvd::load_matrix> : checksum mismatch" );
+      }
+      return m;
+    }
+
+template<
+    typename _Ty,
+    size_t col_size>
+    matrix<_Ty, col_size> load_matrix( std::string const& path )
+    {
+      std::ifstream i( path, std::ios::binary );
+      if( !i ) {
+          throw TVD_EXCEPTION( "<tvd::load_matrix> : cannot open " + path );
+      }
+      return load_matrix<_Ty, col_size>( i );
+    }
+// read-only mapping of a file written by save_matrix; view() points into the mapping, nothing is read
+// until it is touched. the header is checked on open, the checksum only by verify(), which reads it all.
+// move-only, the views must not outlive it
+template<typename _Ty>
+    class mapped_matrix
+    {
+      const char        *base_;
+      size_t             length_;
+      matrix_file_header header_;
+#if defined(_WIN32)
+      HANDLE             mapping_;
+#endif
+public :
+      explicit mapped_matrix( std::string const& path )
+        : base_( nullptr )
+        , length_( 0 )
+        , header_{}
+#if defined(_WIN32)
+        , mapping_( nullptr )
+#endif
+      {
+        map( path );
+        try {
+            if( length_ < sizeof(matrix_file_header) ) {
+                throw TVD_EXCEPTION( "<mapped_matrix::mapped_matrix> : not a matrix file" );
+            }
+            std::memcpy( &header_, base_, sizeof(header_) );
+            detail::check_matrix_file<_Ty>( header_, length_, "<mapped_matrix::mapped_matrix>" );
+            if( header_.rows*header_.col_size == 0 ) {
+                throw TVD_EXCEPTION( "<mapped_matrix::mapped_matrix> : the matrix is empty" );
+            }
+        } catch( ... ) {
+            unmap();
+            throw;
+        }
+      }
+
+      mapped_matrix( mapped_matrix && other ) noexcept
+        : base_( std::exchange( other.base_, nullptr ) )
+        , length_( std::exchange( other.length_, 0 ) )
+        , header_( other.header_ )
+#if defined(_WIN32)
+        , mapping_( std::exchange( other.mapping_, nullptr ) )
+#endif
+      {
+      }
+
+      mapped_matrix & operator = ( mapped_matrix && other ) noexcept
+      {
+        if( this == &other ) return *this;
+        unmap();
+        base_   = std::exchange( other.base_, nullptr );
+        length_ = std::exchange( other.length_, 0 );
+        header_ = other.header_;
+#if defined(_WIN32)
+        mapping_ = std::exchange( other.mapping_, nullptr );
+#endif
+        return *this;
+      }
+
+      mapped_matrix( mapped_matrix const& ) = delete;
+      mapped_matrix & operator = ( mapped_matrix const& ) = delete;
+
+      ~mapped_matrix() {
+        unmap();
+      }
+
+      matrix_file_header const& header() const noexcept {
+        return header_;
+      }
+
+      const _Ty* data() const noexcept {
+        return reinterpret_cast<const _Ty*>( base_ + header_.data_offset );
+      }
+
+      size_t size() const noexcept {
+        return header_.rows;
+      }
+
+      size_t csize() const noexcept {
+        return header_.col_size;
+      }
+
+      matrix_view<_Ty> view() const {
+        return matrix_view<_Ty>( data(), size(), csize() );
+      }
+      // reads the whole mapping
+      bool verify() const noexcept {
+        return detail::matrix_file_checksum( data(), size()*csize()*sizeof(_Ty) ) == header_.checksum;
+      }
+private :
+
+      void map( std::string const& path )
+      {
+#if defined(_WIN32)
+        HANDLE file = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+        if( file == INVALID_HANDLE_VALUE ) {
+            throw TVD_EXCEPTION( "<mapped_matrix::map> : cannot open " + path );
+        }
+        LARGE_INTEGER size;
+        if( !GetFileSizeEx( file, &size ) || size.QuadPart == 0 ) {
+            CloseHandle( file );
+            throw TVD_EXCEPTION( "<mapped_matrix::map> : not a matrix file" );
+        }
+        mapping_ = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+        CloseHandle( file );
+        if( !mapping_ ) {
+            throw TVD_EXCEPTION( "<mapped_matrix::map> : cannot map " + path );
+        }
+        base_ = static_cast<const char*>( MapViewOfFile( mapping_, FILE_MAP_READ, 0, 0, 0 ) );
+        if( !base_ ) {
+            CloseHandle( std::exchange( mapping_, nullptr ) );
+            throw TVD_EXCEPTION( "<mapped_matrix::map> : cannot map " + path );
+        }
+        length_ = static_cast<size_t>( size.QuadPart );
+#else
+        const int fd = ::open( path.c_str(), O_RDONLY );
+        if( fd < 0 ) {
+            throw TVD_EXCEPTION( "<mapped_matrix::map> : cannot open " + path );
+        }
+        struct stat st;
+        if( ::fstat( fd, &st ) != 0 || st.st_size == 0 ) {
+            ::close( fd );
+            throw TVD_EXCEPTION( "<mapped_matrix::map> : not a matrix file" );
+        }
+        void *p = ::mmap( nullptr, static_cast<size_t>( st.st_size ), PROT_READ, MAP_SHARED, fd, 0 );
+        ::close( fd );
+        if( p == MAP_FAILED ) {
+            throw TVD_EXCEPTION( "<mapped_matrix::map> : cannot map " + path );
+        }
+        base_   = static_cast<const char*>( p );
+        length_ = static_cast<size_t>( st.st_size );
+#endif
+      }
+
+      void unmap() noexcept
+      {
+        if( !base_ ) {
+            return;
+        }
+#if defined(_WIN32)
+        UnmapViewOfFile( base_ );
+        CloseHandle( mapping_ );
+        mapping_ = nullptr;
+#else
+        ::munmap( const_cast<char*>( base_ ), length_ );
+#endif
+        base_   = nullptr;
+        length_ = 0;
+      }
+    };
+} // tvd
+#endif
@@ -0,0 +1,249 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the matrix multiplication kernel
+#pragma once
+#ifndef TVD_MATRIX_GEMM_HPP
+#define TVD_MATRIX_GEMM_HPP
+
+#include "tvd/thread_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace tvd {
+    // parallel mode of the matrix product, the thread count is the one of thread_pool::instance()
+    struct gemm_settings
+    {
+      bool   parallel        = true;
+      // products with a smaller volume m*n*k stay on the calling thread
+      size_t parallel_volume = 128*128*128;
+    };
+
+    inline gemm_settings & gemm_config()
+    {
+      static gemm_settings settings;
+      return settings;
+    }
+
+    namespace detail {
+      // blocking parameters : <mr>x<nr> register tile, <mc>x<kc> block of A (L2), <kc>x<nc> panel of B (L3)
+  template<typename _Ty>
+      struct gemm_blocking
+      {
+        static constexpr size_t mr = 4;
+        static constexpr size_t nr = sizeof(_Ty) >= 8 ? 4 : 8;
+        static constexpr size_t kc = 256;
+        static constexpr size_t mc = ( ( 128*1024/( kc*sizeof(_Ty) ) )/mr )*mr;
+        static constexpr size_t nc = 4096;
+        // products below this volume are not worth packing
+        static constexpr size_t small_volume = 32*32*32;
+      };
+      // pack buffers are kept per thread and only ever grow
+  template<typename _Ty>
+      struct gemm_buffers
+      {
+        std::vector<_Ty> a;
+        std::vector<_Ty> b;
+
+        static gemm_buffers & local()
+        {
+          thread_local gemm_buffers buffers;
+          return buffers;
+        }
+      };
+      // C += alpha*A*B without packing, i-k-j order keeps the inner loop contiguous over B and C rows
+  template<typename _Ty>
+      void gemm_small( size_t m, size_t n, size_t k, _Ty alpha,
+                       const _Ty *a, ptrdiff_t rsa, ptrdiff_t csa,
+                       const _Ty *b, ptrdiff_t rsb, ptrdiff_t csb,
+                       _Ty       *c, ptrdiff_t rsc, ptrdiff_t csc  )
+      {
+        for( size_t i(0); i < m; i++ )
+        {
+            _Ty *c_row = c + i*rsc;
+            for( size_t p(0); p < k; p++ )
+            {
+                const _Ty  a_ip  = alpha*a[i*rsa + p*csa];
+                const _Ty *b_row = b + p*rsb;
+                if( csb == 1 && csc == 1 ) {
+                    for( size_t j(0); j < n; j++ ) {
+                        c_row[j] += a_ip*b_row[j];
+                    }
+                } else {
+                    for( size_t j(0); j < n; j++ ) {
+                        c_row[j*csc] += a_ip*b_row[j*csb];
+                    }
+                }
+            }
+        }
+      }
+      // packs a <mc>x<kc> block of A into <mr>-row micro-panels, tails are zero-padded
+  template<typename _Ty>
+      void gemm_pack_a( size_t mc, size_t kc, const _Ty *a, ptrdiff_t rsa, ptrdiff_t csa, _Ty *pack )
+      {
+        constexpr size_t mr = gemm_blocking<_Ty>::mr;
+        for( size_t ir(0); ir < mc; ir += mr )
+        {
+            const size_t m = std::min( mr, mc - ir );
+            for( size_t p(0); p < kc; p++ )
+            {
+                for( size_t i(0); i < m; i++ ) {
+                    pack[i] = a[( ir + i )*rsa + p*csa];
+                }
+                for( size_t i(m); i < mr; i++ ) {
+                    pack[i] = _Ty(0);
+                }
+                pack += mr;
+            }
+        }
+      }
+      // packs a <kc>x<nc> panel of B into <nr>-column micro-panels, tails are zero-padded
+  template<typename _Ty>
+      void gemm_pack_b( size_t kc, size_t nc, const _Ty *b, ptrdiff_t rsb, ptrdiff_t csb, _Ty *pack )
+      {
+        constexpr size_t nr = gemm_blocking<_Ty>::nr;
+        for( size_t jr(0); jr < nc; jr += nr )
+        {
+            const size_t n = std::min( nr, nc - jr );
+            for( size_t p(0); p < kc; p++ )
+            {
+                const _Ty *b_row = b + p*rsb + jr*csb;
+                for( size_t j(0); j < n; j++ ) {
+                    pack[j] = b_row[j*csb];
+                }
+                for( size_t j(n); j < nr; j++ ) {
+                    pack[j] = _Ty(0);
+                }
+                pack += nr;
+            }
+        }
+      }
+      // <mr>x<nr> tile of C accumulated in registers over a packed <kc> slice
+  template<typename _Ty>
+      inline void gemm_micro_kernel( size_t kc, _Ty alpha, const _Ty *a, const _Ty *b,
+                                     _Ty *c, ptrdiff_t rsc, ptrdiff_t csc, size_t m, size_t n )
+      {
+        constexpr size_t mr = gemm_blocking<_Ty>::mr;
+        constexpr size_t nr = gemm_blocking<_Ty>::nr;
+
+        _Ty ab[mr*nr] = {};
+        for( size_t p(0); p < kc; p++, a += mr, b += nr )
+        {
+            for( size_t i(0); i < mr; i++ ) {
+                for( size_t j(0); j < nr; j++ ) {
+                    ab[i*nr + j] += a[i]*b[j];
+                }
+            }
+        }
+        if( m == mr && n == nr && csc == 1 ) {
+            for( size_t i(0); i < mr; i++ ) {
+                for( size_t j(0); j < nr; j++ ) {
+                    c[i*rsc + j] += alpha*ab[i*nr + j];
+                }
+            }
+        } else {
+            for( size_t i(0); i < m; i++ ) {
+                for( size_t j(0); j < n; j++ ) {
+                    c[i*rsc + j*csc] += alpha*ab[i*nr + j];
+                }
+            }
+        }
+      }
+      // C[m x n] += alpha*A[m x k]*B[k x n] on the calling thread
+  template<typename _Ty>
+      void gemm_serial( size_t m, size_t n, size_t k, _Ty alpha,
+                        const _Ty *a, ptrdiff_t rsa, ptrdiff_t csa,
+                        const _Ty *b, ptrdiff_t rsb, ptrdiff_t csb,
+                        _Ty       *c, ptrdiff_t rsc, ptrdiff_t csc  )
+      {
+        using blocking_t = gemm_blocking<_Ty>;
+        constexpr size_t mr = blocking_t::mr;
+        constexpr size_t nr = blocking_t::nr;
+        constexpr size_t mc = blocking_t::mc;
+        constexpr size_t kc = blocking_t::kc;
+        constexpr size_t nc = blocking_t::nc;
+
+        if( m == 0 || n == 0 || k == 0 ) {
+            return;
+        }
+        if( m*n*k <= blocking_t::small_volume || n < nr || k < mr ) {
+            gemm_small( m, n, k, alpha, a, rsa, csa, b, rsb, csb, c, rsc, csc );
+            return;
+        }
+
+        auto & buffers = gemm_buffers<_Ty>::local();
+        const size_t n_panel = std::min( nc, ( n + nr - 1 )/nr*nr );
+        const size_t m_block = std::min( mc, ( m + mr - 1 )/mr*mr );
+        buffers.b.resize( std::max( buffers.b.size(), std::min( kc, k )*n_panel ) );
+        buffers.a.resize( std::max( buffers.a.size(), m_block*std::min( kc, k ) ) );
+
+        for( size_t jc(0); jc < n; jc += nc )
+        {
+            const size_t n_c = std::min( nc, n - jc );
+            for( size_t pc(0); pc < k; pc += kc )
+            {
+                const size_t k_c = std::min( kc, k - pc );
+                gemm_pack_b( k_c, n_c, b + pc*rsb + jc*csb, rsb, csb, buffers.b.data() );
+
+                for( size_t ic(0); ic < m; ic += mc )
+                {
+                    const size_t m_c = std::min( mc, m - ic );
+                    gemm_pack_a( m_c, k_c, a + ic*rsa + pc*csa, rsa, csa, buffers.a.data() );
+
+                    for( size_t jr(0); jr < n_c; jr += nr )
+                    {
+                        const _Ty *b_panel = buffers.b.data() + jr*k_c;
+                        for( size_t ir(0); ir < m_c; ir += mr )
+                        {
+                            gemm_micro_kernel( k_c, alpha, buffers.a.data() + ir*k_c, b_panel,
+                                               c + ( ic + ir )*rsc + ( jc + jr )*csc, rsc, csc,
+                                               std::min( mr, m_c - ir ), std::min( nr, n_c - jr ) );
+                        }
+                    }
+                }
+            }
+        }
+      }
+      // C[m x n] += alpha*A[m x k]*B[k x n], every operand is addressed by (row stride, col stride);
+      // large products are split into output tiles run on the shared pool, every element of C is
+      // reduced by exactly one tile in a fixed order, so results repeat for the same thread count
+  template<typename _Ty>
+      void gemm( size_t m, size_t n, size_t k, _Ty alpha,
+                 const _Ty *a, ptrdiff_t rsa, ptrdiff_t csa,
+                 const _Ty *b, ptrdiff_t rsb, ptrdiff_t csb,
+                 _Ty       *c, ptrdiff_t rsc, ptrdiff_t csc  )
+      {
+        using blocking_t = gemm_blocking<_Ty>;
+        constexpr size_t mr = blocking_t::mr;
+        constexpr size_t nr = blocking_t::nr;
+
+        auto const& settings = gemm_config();
+        auto & pool = thread_pool::instance();
+        if( !settings.parallel || pool.size() == 1 || m*n*k < settings.parallel_volume ) {
+            gemm_serial( m, n, k, alpha, a, rsa, csa, b, rsb, csb, c, rsc, csc );
+            return;
+        }
+
+        auto div_up = []( size_t x, size_t y ) { return ( x + y - 1 )/y; };
+        const size_t tiles  = 2*pool.size();
+        const size_t tile_m = std::min( blocking_t::mc, div_up( div_up( m, tiles ), mr )*mr );
+        const size_t rows   = div_up( m, tile_m );
+        const size_t tile_n = rows >= tiles ? n : div_up( div_up( n, div_up( tiles, rows ) ), nr )*nr;
+        const size_t cols   = div_up( n, tile_n );
+
+        pool.parallel_for( 0, rows*cols, 1, [&]( size_t first, size_t last )
+        {
+          for( size_t t(first); t < last; t++ )
+          {
+              const size_t i = ( t/cols )*tile_m;
+              const size_t j = ( t%cols )*tile_n;
+              gemm_serial( std::min( tile_m, m - i ), std::min( tile_n, n - j ), k, alpha,
+                           a + i*rsa, rsa, csa,
+                           b + j*csb, rsb, csb,
+                           c + i*rsc + j*csc, rsc, csc );
+          }
+        } );
+      }
+    } // detail
+} // tvd
+#endif
@@ -2,46 +2,425 @@
 #ifndef TVD_IO_HPP
 #define TVD_IO_HPP
 
+#include "tvd/thread_pool.hpp"
 #include "matrix.hpp"
 #include "matrix_view.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
 
 namespace tvd {
 
+    namespace detail {
+      // floating point to_chars / from_chars come with libstdc++ 11, msvc 19.24; older libraries use the C calls
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+      inline constexpr bool text_float_charconv = true;
+#else
+      inline constexpr bool text_float_charconv = false;
+#endif
+      // longest text of one value
+      inline constexpr size_t text_value_size = 64;
+
+      // shortest text that reads back to the same value, returns its end
+  template<typename _Ty>
+      char* text_format( char *first, _Ty value )
+      {
+        if constexpr( std::is_integral_v<_Ty> || text_float_charconv ) {
+            return std::to_chars( first, first + text_value_size, value ).ptr;
+        } else if constexpr( std::is_same_v<_Ty, long double> ) {
+            return first + std::snprintf( first, text_value_size, "%.*Lg", std::numeric_limits<_Ty>::max_digits10, value );
+        } else {
+            return first + std::snprintf( first, text_value_size, "%.*g", std::numeric_limits<_Ty>::max_digits10, double( value ) );
+        }
+      }
+      // the value at [first, last), <last> is a separator; returns the end of the number, <first> when there is none
+  template<typename _Ty>
+      const char* text_parse( const char *first, const char *last, _Ty & value )
+      {
+        if constexpr( std::is_integral_v<_Ty> || text_float_charconv ) {
+            const auto r = std::from_chars( first, last, value );
+            return r.ec == std::errc() ? r.ptr : first;
+        } else {
+            char *end = const_cast<char*>( first );
+            if constexpr( std::is_same_v<_Ty, float> ) {
+                value = std::strtof( first, &end );
+            } else if constexpr( std::is_same_v<_Ty, double> ) {
+                value = std::strtod( first, &end );
+            } else {
+                value = std::strtold( first, &end );
+            }
+            return end;
+        }
+      }
+      // values are formatted into a 64k buffer leased from the thread, the stream sees a write per buffer
+      class text_writer
+      {
+        static constexpr size_t capacity = 64*1024;
+
+        std::ostream                  & o_;
+        size_t                          size_;
+        local_lease<std::vector<char> > lease_;
+        char                          * buffer_;
+  public :
+        explicit text_writer( std::ostream & o )
+          : o_( o )
+          , size_( 0 )
+        {
+          if( lease_->size() < capacity ) {
+              lease_->resize( capacity );
+          }
+          buffer_ = lease_->data();
+        }
+
+        text_writer( text_writer const& ) = delete;
+        text_writer & operator = ( text_writer const& ) = delete;
+
+        ~text_writer() {
+          flush();
+        }
+
+    template<typename _Ty>
+        void value( _Ty const& value )
+        {
+          if( size_ + text_value_size > capacity ) {
+              flush();
+          }
+          size_ = text_format( buffer_ + size_, value ) - buffer_;
+        }
+
+        void text( const char *s, size_t n )
+        {
+          if( size_ + n > capacity ) {
+              flush();
+          }
+          if( n > capacity ) {
+              o_.write( s, static_cast<std::streamsize>( n ) );
+              return;
+          }
+          std::memcpy( buffer_ + size_, s, n );
+          size_ += n;
+        }
+
+        void text( char c ) {
+          text( &c, 1 );
+        }
+
+        void text( const char *s ) {
+          text( s, std::strlen( s ) );
+        }
+
+        void flush()
+        {
+          o_.write( buffer_, static_cast<std::streamsize>( size_ ) );
+          size_ = 0;
+        }
+      };
+      // "{ a, b, c,  }" as the earlier ostream_iterator output
+  template<class _RowTy>
+      void text_braced_row( text_writer & w, _RowTy const& row, size_t n )
+      {
+        for( size_t j(0); j < n; j++ ) {
+            w.value( row[j] );
+            w.text( ", ", 2 );
+        }
+      }
+      // values of one line [first, last) split by <delimiter> and/or blanks, at most <col_size>; returns the count
+  template<typename _Ty>
+      size_t text_parse_line( const char *first, const char *last, size_t col_size, char delimiter, _Ty *values, size_t line )
+      {
+        auto separator = [delimiter]( char c ) {
+          return c == delimiter || c == ' ' || c == '\t' || c == '\r';
+        };
+        size_t count = 0;
+        for( const char *p(first);; )
+        {
+            while( p < last && separator( *p ) ) {
+                p++;
+            }
+            if( p == last ) {
+                return count;
+            }
+            if( count == col_size ) {
+                throw TVD_EXCEPTION( "<tvd::read_text> : line " + std::to_string( line ) + " has too many values" );
+            }
+            const char *next = text_parse( p, last, values[count] );
+            if( next == p || ( next < last && !separator( *next ) ) ) {
+                throw TVD_EXCEPTION( "<tvd::read_text> : line " + std::to_string( line ) + " : bad value" );
+            }
+            p = next;
+            count++;
+        }
+      }
+      // rows of <col_size> values, one per line, blank lines skipped. the stream is read to its end in 64k chunks
+      // and only whole lines are parsed. before the first row reserve( rows ) gets the row count expected from
+      // the newlines of the first chunk and the <bytes> left in the stream, 0 when that is unknown;
+      // row( values ) then gets every row in order
+  template<
+      typename _Ty,
+      class _ReserveFnTy,
+      class _RowFnTy>
+      void text_read_rows( std::istream & i, size_t col_size, char delimiter, size_t bytes, _ReserveFnTy && reserve, _RowFnTy && row )
+      {
+        std::vector<char> buffer( 64*1024 );
+        std::vector<_Ty>  values( col_size );
+        size_t size = 0, line = 0;
+        bool eof = false, first_chunk = true;
+        for( ;; )
+        {
+            if( !eof && size < buffer.size() ) {
+                i.read( buffer.data() + size, static_cast<std::streamsize>( buffer.size() - size ) );
+                size += static_cast<size_t>( i.gcount() );
+                eof = !i;
+            }
+            const char *first = buffer.data(), *last = first + size;
+            // whole lines only, the tail waits for the next chunk
+            const char *end = last;
+            if( !eof )
+            {
+                while( end > first && end[-1] != '\n' ) {
+                    end--;
+                }
+                if( end == first ) {
+                    buffer.resize( buffer.size()*2 );
+                    continue;
+                }
+            }
+            if( first_chunk )
+            {
+                const size_t lines = std::count( first, end, '\n' ) + ( eof && end > first && end[-1] != '\n' );
+                const size_t expected = end > first ? size_t( double( bytes )*lines/( end - first ) ) : 0;
+                reserve( eof ? lines : expected + expected/8 + 1 );
+                first_chunk = false;
+            }
+            for( const char *p(first); p < end; )
+            {
+                const char *eol = static_cast<const char*>( std::memchr( p, '\n', end - p ) );
+                if( !eol ) {
+                    eol = end;
+                }
+                const size_t count = text_parse_line( p, eol, col_size, delimiter, values.data(), ++line );
+                if( count != 0 && count != col_size ) {
+                    throw TVD_EXCEPTION( "<tvd::read_text> : line " + std::to_string( line ) + " has too few values" );
+                }
+                if( count != 0 ) {
+                    row( static_cast<const _Ty*>( values.data() ) );
+                }
+                p = eol + 1;
+            }
+            if( eof ) {
+                return;
+            }
+            size = static_cast<size_t>( last - end );
+            std::memmove( buffer.data(), end, size );
+        }
+      }
+    } // detail
+// <m> as <delimiter> separated text, one row per line, every value in its shortest exact form
+template<
+    typename _Ty,
+    size_t col_size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    void write_text( std::ostream & o, matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> const& m, char delimiter = ',' )
+    {
+      detail::text_writer w( o );
+      const _Ty *p = m.data();
+      for( size_t i(0); i < m.size(); i++, p += col_size )
+      {
+          for( size_t j(0); j < col_size; j++ )
+          {
+              if( j ) w.text( delimiter );
+              w.value( p[j] );
+          }
+          w.text( '\n' );
+      }
+    }
+
+template<
+    typename _Ty,
+    size_t size>
+    void write_text( std::ostream & o, vector<_Ty, size> const& v, char delimiter = ',' )
+    {
+      detail::text_writer w( o );
+      for( size_t j(0); j < size; j++ )
+      {
+          if( j ) w.text( delimiter );
+          w.value( v[j] );
+      }
+      w.text( '\n' );
+    }
+// reads the rest of <i> written by write_text into <m>, values may be split by <delimiter>, blanks or both.
+// the rows go straight into the storage of <m>; for a seekable stream it is sized once from the byte count
+// and the lines of the first 64k, otherwise it doubles. returns the number of rows
+template<
+    typename _Ty,
+    size_t col_size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    size_t read_text( std::istream & i, matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> & m, char delimiter = ',' )
+    {
+      using matrix_t = matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy>;
+      size_t bytes = 0;
+      const auto start = i.tellg();
+      if( start != std::istream::pos_type( -1 ) && i.seekg( 0, std::ios::end ) ) {
+          bytes = static_cast<size_t>( i.tellg() - start );
+          i.seekg( start );
+      }
+      i.clear();
+      matrix_t r;
+      size_t rows = 0, capacity = 0;
+      detail::text_read_rows<_Ty>( i, col_size, delimiter, bytes,
+        [&]( size_t expected )
+        {
+          capacity = std::max<size_t>( expected, 16 );
+          r = matrix_t( capacity );
+        },
+        [&]( const _Ty *values )
+        {
+          if( rows == capacity )
+          {
+              matrix_t grown( capacity*2 );
+              std::copy_n( r.data(), rows*col_size, grown.data() );
+              r = std::move( grown );
+              capacity *= 2;
+          }
+          std::copy_n( values, col_size, r.data() + rows*col_size );
+          rows++;
+        } );
+      r.resize( rows );
+      m = std::move( r );
+      return rows;
+    }
+// the next line with values, false at the end of <i>
+template<
+    typename _Ty,
+    size_t size>
+    bool read_text( std::istream & i, vector<_Ty, size> & v, char delimiter = ',' )
+    {
+      std::string text;
+      _Ty values[size];
+      for( size_t line(1); std::getline( i, text ); line++ )
+      {
+          const size_t count = detail::text_parse_line( text.data(), text.data() + text.size(), size, delimiter, values, line );
+          if( count == 0 ) {
+              continue;
+          }
+          if( count != size ) {
+              throw TVD_EXCEPTION( "<tvd::read_text> : line " + std::to_string( line ) + " has too few values" );
+          }
+          for( size_t j(0); j < size; j++ ) {
+              v[j] = values[j];
+          }
+          return true;
+      }
+      return false;
+    }
+// operator >> reads the write_text form with ',' or blanks between the values and throws on a malformed line.
+// the matrix takes the rest of <i>, so a clean read leaves only eofbit set; failbit is set for a stream that
+// was already failed, has no rows left or has a malformed line
+template<
+    typename _Ty,
+    size_t col_size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    std::istream & operator >> ( std::istream & i, matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> & m )
+    {
+      if( !i ) {
+          i.setstate( std::ios::failbit );
+          return i;
+      }
+      size_t rows = 0;
+      try {
+          rows = read_text( i, m );
+      } catch( ... ) {
+          i.setstate( std::ios::failbit );
+          throw;
+      }
+      i.clear( ( i.rdstate() & std::ios::badbit ) | std::ios::eofbit );
+      if( rows == 0 ) {
+          i.setstate( std::ios::failbit );
+      }
+      return i;
+    }
+
 template<
     typename _Ty,
     size_t size>
-    std::ostream & operator << ( std::ostream & o, vector<_Ty, size> v )
+    std::istream & operator >> ( std::istream & i, vector<_Ty, size> & v )
+    {
+      if( !read_text( i, v ) ) {
+          i.setstate( std::ios::failbit );
+      }
+      return i;
+    }
+
+template<
+    typename _Ty,
+    size_t size>
+    std::ostream & operator << ( std::ostream & o, vector<_Ty, size> const& v )
+    {
+      detail::text_writer w( o );
+      w.text( '[' );
+      w.value( size );
+      w.text( "]{" );
+      detail::text_braced_row( w, v, size );
+      w.text( "}\n" );
+      return o;
+    }
+
+template<
+    typename _Ty,
+    size_t extent>
+    std::ostream & operator << ( std::ostream & o, row_ref<_Ty, extent> const& r )
     {
-      o << "[" << size << "]{";
-      std::ostream_iterator<_Ty> out_itr ( o, ", ");
-      std::copy( v.begin(), v.end(), out_itr );
-      o << "}" << std::endl;
+      detail::text_writer w( o );
+      w.text( '[' );
+      w.value( r.size() );
+      w.text( "]{" );
+      detail::text_braced_row( w, r, r.size() );
+      w.text( "}\n" );
       return o;
     }
 
 template<typename _Ty>
-    std::ostream & operator << ( std::ostream & o, matrix_view<_Ty> m )
+    std::ostream & operator << ( std::ostream & o, matrix_view<_Ty> const& m )
     {
-      using std::endl;
-      o << "[" << m.size()  << "]" << endl;
-      o << "[" << m.csize() << "]" << endl;
-      for(size_t i = 0; i < std::size( m ); i++)
+      detail::text_writer w( o );
+      w.text( '[' );
+      w.value( m.size() );
+      w.text( "]\n[" );
+      w.value( m.csize() );
+      w.text( "]\n" );
+      for(size_t i = 0; i < m.size(); i++)
       {
-          o << "{ ";
-          std::ostream_iterator<_Ty> out_itr ( o, ", ");
-          std::copy( m[i].begin(), m[i].end(), out_itr );
-          o << " }" << endl;
+          w.text( "{ " );
+          detail::text_braced_row( w, m[i], m.csize() );
+          w.text( " }\n" );
       }
       return o;
     }
 
 template<
     typename _Ty,
-    size_t size>
-    std::ostream & operator << ( std::ostream & o, matrix<_Ty, size> m ) {
+    size_t size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    std::ostream & operator << ( std::ostream & o, matrix<_Ty, size, _ElemTraitsTy, _AllocTy> const& m ) {
       return o << matrix_view<_Ty>( m );
     }
+
+template<
+    class _ExprTy,
+    std::enable_if_t<is_expression_v<_ExprTy>, bool> = true>
+    std::ostream & operator << ( std::ostream & o, _ExprTy const& e ) {
+      return o << typename _ExprTy::result_t( e );
+    }
 } // tvd
 #endif
@@ -0,0 +1,587 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the iterative linear solvers
+#pragma once
+#ifndef TVD_MATRIX_ITERATIVE_HPP
+#define TVD_MATRIX_ITERATIVE_HPP
+
+#include "tvd/exception.hpp"
+#include "tvd/thread_pool.hpp"
+#include "tvd/matrix/gemm.hpp"
+#include "tvd/matrix/matrix.hpp"
+#include "tvd/matrix/sparse_matrix.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace tvd {
+// an operator is anything callable as op( const _Ty *x, _Ty *y ) that writes y = A*x for the n unknowns;
+// a sparse_matrix and a square matrix are wrapped by linear_operator(), which checks them against n, a lambda
+// is taken as it is. a preconditioner is anything with apply( const _Ty *r, _Ty *z ) writing z ~ A^-1*r,
+// one with size() is checked against n
+    struct solver_settings
+    {
+      size_t max_iterations = 1000;
+      // stop once |b - A*x| <= tolerance*|b|
+      double tolerance      = 1e-8;
+      // the vector updates and the dot products run on the thread pool, the dot products
+      // are summed in a fixed order, so results repeat for the same thread count
+      bool   parallel       = false;
+    };
+
+    struct solver_result
+    {
+      size_t iterations = 0;
+      double residual   = 0;  // |b - A*x|/|b| of the returned x
+      bool   converged  = false;
+    };
+// vectors of the solvers, sized to the largest system seen and reused between solves. a solve holds its
+// workspace until it returns, across the parallel_for calls of the parallel mode too, so solves that may
+// run at the same time, nested in a parallel_for included, need workspaces of their own; the overloads
+// without one lease the thread's workspace, see local_lease
+template<typename _Ty>
+    class solver_workspace
+    {
+      std::vector<std::vector<_Ty> > vectors_;
+      std::vector<_Ty>               partial_;
+public :
+      // vector <i> with at least <n> elements
+      _Ty* get( size_t i, size_t n )
+      {
+        if( vectors_.size() <= i ) {
+            vectors_.resize( i + 1 );
+        }
+        if( vectors_[i].size() < n ) {
+            vectors_[i].resize( n );
+        }
+        return vectors_[i].data();
+      }
+      // per-chunk sums of the parallel dot products
+      std::vector<_Ty> & partial() noexcept {
+        return partial_;
+      }
+    };
+
+    namespace detail {
+      // elements per chunk of the parallel vector kernels
+      inline constexpr size_t solver_grain = 16*1024;
+
+  template<class _FnTy>
+      void solver_for( size_t n, bool parallel, _FnTy && fn )
+      {
+        if( !parallel || n <= solver_grain ) {
+            fn( size_t(0), n );
+            return;
+        }
+        tvd::parallel_for( 0, n, solver_grain, fn );
+      }
+
+  template<typename _Ty>
+      _Ty solver_dot( solver_workspace<_Ty> & ws, size_t n, const _Ty *x, const _Ty *y, bool parallel )
+      {
+        auto dot = [&]( size_t first, size_t last )
+        {
+          _Ty sum = _Ty(0);
+          for( size_t i(first); i < last; i++ ) {
+              sum += x[i]*y[i];
+          }
+          return sum;
+        };
+        if( !parallel || n <= solver_grain ) {
+            return dot( 0, n );
+        }
+        auto & partial = ws.partial();
+        partial.assign( ( n + solver_grain - 1 )/solver_grain, _Ty(0) );
+        tvd::parallel_for( 0, n, solver_grain, [&]( size_t first, size_t last ) {
+          partial[first/solver_grain] = dot( first, last );
+        } );
+        _Ty sum = _Ty(0);
+        for( auto p : partial ) {
+            sum += p;
+        }
+        return sum;
+      }
+      // y = x + k*y
+  template<typename _Ty>
+      void solver_xpby( size_t n, const _Ty *x, _Ty k, _Ty *y, bool parallel )
+      {
+        solver_for( n, parallel, [&]( size_t first, size_t last ) {
+          for( size_t i(first); i < last; i++ ) {
+              y[i] = x[i] + k*y[i];
+          }
+        } );
+      }
+      // y += k*x
+  template<typename _Ty>
+      void solver_axpy( size_t n, _Ty k, const _Ty *x, _Ty *y, bool parallel )
+      {
+        solver_for( n, parallel, [&]( size_t first, size_t last ) {
+          for( size_t i(first); i < last; i++ ) {
+              y[i] += k*x[i];
+          }
+        } );
+      }
+      // r = b - r, r holding A*x
+  template<typename _Ty>
+      void solver_residual( size_t n, const _Ty *b, _Ty *r, bool parallel )
+      {
+        solver_for( n, parallel, [&]( size_t first, size_t last ) {
+          for( size_t i(first); i < last; i++ ) {
+              r[i] = b[i] - r[i];
+          }
+        } );
+      }
+    } // detail
+// A*x of a sparse matrix, parallel over the rows, for <n> unknowns
+template<
+    typename _Ty,
+    typename _IndexTy>
+    auto linear_operator( sparse_matrix<_Ty, _IndexTy> const& a, size_t n )
+    {
+      if( a.rows() != a.cols() ) {
+          throw TVD_EXCEPTION( "<tvd::linear_operator> : <a> is not square" );
+      }
+      if( a.rows() != n ) {
+          throw TVD_EXCEPTION( "<tvd::linear_operator> : <a.rows> != <n>" );
+      }
+      return [&a]( const _Ty *x, _Ty *y ) { detail::spmv( a, x, y ); };
+    }
+// A*x of a square dense matrix through the gemm kernel, for <n> unknowns
+template<
+    typename _Ty,
+    size_t col_size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    auto linear_operator( matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> const& a, size_t n )
+    {
+      if( a.size() != col_size ) {
+          throw TVD_EXCEPTION( "<tvd::linear_operator> : <a> is not square" );
+      }
+      if( col_size != n ) {
+          throw TVD_EXCEPTION( "<tvd::linear_operator> : <col_size> != <n>" );
+      }
+      return [&a]( const _Ty *x, _Ty *y )
+      {
+        std::fill( y, y + col_size, _Ty(0) );
+        detail::gemm<_Ty>( col_size, 1, col_size, _Ty(1), a.data(), col_size, 1, x, 1, 1, y, 1, 1 );
+      };
+    }
+// a callable is already an operator, its size is the caller's care
+template<class _OpTy>
+    _OpTy const& linear_operator( _OpTy const& op, size_t ) noexcept {
+      return op;
+    }
+
+template<typename _Ty>
+    struct identity_preconditioner
+    {
+      size_t n;
+
+      size_t size() const noexcept {
+        return n;
+      }
+
+      void apply( const _Ty *r, _Ty *z ) const {
+        std::copy( r, r + n, z );
+      }
+    };
+// z = D^-1*r with D the diagonal of A
+template<typename _Ty>
+    class jacobi_preconditioner
+    {
+      std::vector<_Ty> inverse_;
+public :
+      explicit jacobi_preconditioner( std::vector<_Ty> const& diagonal )
+        : inverse_( diagonal.size() )
+      {
+        for( size_t i(0); i < diagonal.size(); i++ )
+        {
+            if( diagonal[i] == _Ty(0) ) {
+                throw TVD_EXCEPTION( "<jacobi_preconditioner::jacobi_preconditioner> : zero on the diagonal" );
+            }
+            inverse_[i] = _Ty(1)/diagonal[i];
+        }
+      }
+
+  template<typename _IndexTy>
+      explicit jacobi_preconditioner( sparse_matrix<_Ty, _IndexTy> const& a )
+        : jacobi_preconditioner( diagonal( a ) )
+      {
+      }
+
+  template<
+      size_t col_size,
+      typename _ElemTraitsTy,
+      typename _AllocTy>
+      explicit jacobi_preconditioner( matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> const& a )
+        : jacobi_preconditioner( diagonal( a ) )
+      {
+      }
+
+      size_t size() const noexcept {
+        return inverse_.size();
+      }
+      // D^-1
+      const _Ty* inverse() const noexcept {
+        return inverse_.data();
+      }
+
+      void apply( const _Ty *r, _Ty *z ) const
+      {
+        for( size_t i(0); i < inverse_.size(); i++ ) {
+            z[i] = inverse_[i]*r[i];
+        }
+      }
+private :
+
+  template<typename _IndexTy>
+      static std::vector<_Ty> diagonal( sparse_matrix<_Ty, _IndexTy> const& a )
+      {
+        std::vector<_Ty> d( a.rows() );
+        for( size_t i(0); i < a.rows(); i++ ) {
+            d[i] = a.at( i, i );
+        }
+        return d;
+      }
+
+  template<
+      size_t col_size,
+      typename _ElemTraitsTy,
+      typename _AllocTy>
+      static std::vector<_Ty> diagonal( matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> const& a )
+      {
+        std::vector<_Ty> d( std::min( a.size(), col_size ) );
+        for( size_t i(0); i < d.size(); i++ ) {
+            d[i] = a.data()[i*col_size + i];
+        }
+        return d;
+      }
+    };
+// incomplete LU without fill-in : L and U keep the pattern of A, z = U^-1*L^-1*r
+template<
+    typename _Ty,
+    typename _IndexTy = uint32_t>
+    class ilu0_preconditioner
+    {
+      sparse_matrix<_Ty, _IndexTy> lu_;
+      std::vector<size_t>          diagonal_;  // position of (i, i) in the row i
+public :
+      explicit ilu0_preconditioner( sparse_matrix<_Ty, _IndexTy> const& a )
+        : lu_( a )
+        , diagonal_( a.rows() )
+      {
+        const size_t    n       = a.rows();
+        const size_t   *offsets = lu_.offsets();
+        const _IndexTy *columns = lu_.columns();
+        _Ty            *values  = lu_.values();
+        if( a.cols() != n ) {
+            throw TVD_EXCEPTION( "<ilu0_preconditioner::ilu0_preconditioner> : <a> is not square" );
+        }
+        for( size_t i(0); i < n; i++ )
+        {
+            const auto first = columns + offsets[i], last = columns + offsets[i + 1];
+            const auto it = std::lower_bound( first, last, static_cast<_IndexTy>( i ) );
+            if( it == last || *it != i ) {
+                throw TVD_EXCEPTION( "<ilu0_preconditioner::ilu0_preconditioner> : no diagonal entry" );
+            }
+            diagonal_[i] = it - columns;
+        }
+
+        // row i : l_ik = a_ik/u_kk for every k < i in the pattern, then a_ij -= l_ik*u_kj where (i, j) exists
+        std::vector<size_t> position( n, SIZE_MAX );
+        for( size_t i(0); i < n; i++ )
+        {
+            for( size_t e( offsets[i] ); e < offsets[i + 1]; e++ ) {
+                position[columns[e]] = e;
+            }
+            for( size_t e( offsets[i] ); e < diagonal_[i]; e++ )
+            {
+                const size_t k = columns[e];
+                const _Ty u_kk = values[diagonal_[k]];
+                if( u_kk == _Ty(0) ) {
+                    throw TVD_EXCEPTION( "<ilu0_preconditioner::ilu0_preconditioner> : zero pivot" );
+                }
+                const _Ty l_ik = values[e] /= u_kk;
+                for( size_t f( diagonal_[k] + 1 ); f < offsets[k + 1]; f++ ) {
+                    if( position[columns[f]] != SIZE_MAX ) {
+                        values[position[columns[f]]] -= l_ik*values[f];
+                    }
+                }
+            }
+            for( size_t e( offsets[i] ); e < offsets[i + 1]; e++ ) {
+                position[columns[e]] = SIZE_MAX;
+            }
+        }
+        for( size_t i(0); i < n; i++ ) {
+            if( values[diagonal_[i]] == _Ty(0) ) {
+                throw TVD_EXCEPTION( "<ilu0_preconditioner::ilu0_preconditioner> : zero pivot" );
+            }
+        }
+      }
+
+      size_t size() const noexcept {
+        return lu_.rows();
+      }
+
+      void apply( const _Ty *r, _Ty *z ) const
+      {
+        const size_t    n       = lu_.rows();
+        const size_t   *offsets = lu_.offsets();
+        const _IndexTy *columns = lu_.columns();
+        const _Ty      *values  = lu_.values();
+        for( size_t i(0); i < n; i++ )
+        {
+            _Ty sum = r[i];
+            for( size_t e( offsets[i] ); e < diagonal_[i]; e++ ) {
+                sum -= values[e]*z[columns[e]];
+            }
+            z[i] = sum;
+        }
+        for( size_t i(n); i-- > 0; )
+        {
+            _Ty sum = z[i];
+            for( size_t e( diagonal_[i] + 1 ); e < offsets[i + 1]; e++ ) {
+                sum -= values[e]*z[columns[e]];
+            }
+            z[i] = sum/values[diagonal_[i]];
+        }
+      }
+    };
+
+    namespace detail {
+  template<typename _Ty>
+      void solver_check( std::vector<_Ty> const& b, std::vector<_Ty> & x, const char *fn )
+      {
+        if( x.empty() ) {
+            x.assign( b.size(), _Ty(0) );
+        }
+        if( x.size() != b.size() ) {
+            throw TVD_EXCEPTION( std::string( fn ) + " : <x.size> != <b.size>" );
+        }
+      }
+
+  template<class _PrecondTy, class = void>
+      struct has_size : std::false_type { };
+
+  template<class _PrecondTy>
+      struct has_size<_PrecondTy, std::void_t<decltype( std::declval<_PrecondTy const&>().size() )> > : std::true_type { };
+      // a preconditioner that knows its size must have the size of <b>
+  template<class _PrecondTy>
+      void solver_check( _PrecondTy const& m, size_t n, const char *fn )
+      {
+        if constexpr( has_size<_PrecondTy>::value ) {
+            if( m.size() != n ) {
+                throw TVD_EXCEPTION( std::string( fn ) + " : <m.size> != <b.size>" );
+            }
+        }
+      }
+    } // detail
+// preconditioned conjugate gradients for a symmetric positive definite A; <x> is the initial guess,
+// an empty one starts from zero
+template<
+    typename _Ty,
+    class _OpTy,
+    class _PrecondTy>
+    solver_result conjugate_gradient( _OpTy const& a, std::vector<_Ty> const& b, std::vector<_Ty> & x,
+                                      _PrecondTy const& m, solver_settings const& settings,
+                                      solver_workspace<_Ty> & ws )
+    {
+      detail::solver_check( b, x, "<tvd::conjugate_gradient>" );
+      detail::solver_check( m, b.size(), "<tvd::conjugate_gradient>" );
+      const size_t n = b.size();
+      auto const& op = linear_operator( a, n );
+      const bool   parallel = settings.parallel;
+      _Ty *r = ws.get( 0, n ), *z = ws.get( 1, n ), *p = ws.get( 2, n ), *q = ws.get( 3, n );
+
+      solver_result result;
+      const double b_norm = std::sqrt( double( detail::solver_dot( ws, n, b.data(), b.data(), parallel ) ) );
+      if( b_norm == 0 ) {
+          std::fill( x.begin(), x.end(), _Ty(0) );
+          result.converged = true;
+          return result;
+      }
+      op( x.data(), r );
+      detail::solver_residual( n, b.data(), r, parallel );
+      m.apply( r, z );
+      std::copy( z, z + n, p );
+      _Ty rz = detail::solver_dot( ws, n, r, z, parallel );
+      result.residual = std::sqrt( double( detail::solver_dot( ws, n, r, r, parallel ) ) )/b_norm;
+
+      while( result.residual > settings.tolerance && result.iterations < settings.max_iterations )
+      {
+          op( p, q );
+          const _Ty alpha = rz/detail::solver_dot( ws, n, p, q, parallel );
+          detail::solver_axpy( n, alpha, p, x.data(), parallel );
+          detail::solver_axpy( n, -alpha, q, r, parallel );
+          result.iterations++;
+          result.residual = std::sqrt( double( detail::solver_dot( ws, n, r, r, parallel ) ) )/b_norm;
+          if( result.residual <= settings.tolerance ) {
+              break;
+          }
+          m.apply( r, z );
+          const _Ty rz_next = detail::solver_dot( ws, n, r, z, parallel );
+          detail::solver_xpby( n, z, rz_next/rz, p, parallel );
+          rz = rz_next;
+      }
+      result.converged = result.residual <= settings.tolerance;
+      return result;
+    }
+
+template<
+    typename _Ty,
+    class _OpTy,
+    class _PrecondTy>
+    solver_result conjugate_gradient( _OpTy const& a, std::vector<_Ty> const& b, std::vector<_Ty> & x,
+                                      _PrecondTy const& m, solver_settings const& settings = {} )
+    {
+      local_lease<solver_workspace<_Ty> > ws;
+      return conjugate_gradient( a, b, x, m, settings, *ws );
+    }
+
+template<
+    typename _Ty,
+    class _OpTy>
+    solver_result conjugate_gradient( _OpTy const& a, std::vector<_Ty> const& b, std::vector<_Ty> & x,
+                                      solver_settings const& settings = {} ) {
+      return conjugate_gradient( a, b, x, identity_preconditioner<_Ty>{ b.size() }, settings );
+    }
+// right-preconditioned BiCGSTAB for a general nonsingular A; stops early on a breakdown, result.converged tells
+template<
+    typename _Ty,
+    class _OpTy,
+    class _PrecondTy>
+    solver_result bicgstab( _OpTy const& a, std::vector<_Ty> const& b, std::vector<_Ty> & x,
+                            _PrecondTy const& m, solver_settings const& settings,
+                            solver_workspace<_Ty> & ws )
+    {
+      detail::solver_check( b, x, "<tvd::bicgstab>" );
+      detail::solver_check( m, b.size(), "<tvd::bicgstab>" );
+      const size_t n = b.size();
+      auto const& op = linear_operator( a, n );
+      const bool   parallel = settings.parallel;
+      _Ty *r = ws.get( 0, n ), *r0 = ws.get( 1, n ), *p = ws.get( 2, n ), *v = ws.get( 3, n );
+      _Ty *s = ws.get( 4, n ), *t = ws.get( 5, n ), *y = ws.get( 6, n ), *z = ws.get( 7, n );
+
+      solver_result result;
+      const double b_norm = std::sqrt( double( detail::solver_dot( ws, n, b.data(), b.data(), parallel ) ) );
+      if( b_norm == 0 ) {
+          std::fill( x.begin(), x.end(), _Ty(0) );
+          result.converged = true;
+          return result;
+      }
+      op( x.data(), r );
+      detail::solver_residual( n, b.data(), r, parallel );
+      std::copy( r, r + n, r0 );
+      std::fill( p, p + n, _Ty(0) );
+      std::fill( v, v + n, _Ty(0) );
+      _Ty rho = _Ty(1), alpha = _Ty(1), omega = _Ty(1);
+      result.residual = std::sqrt( double( detail::solver_dot( ws, n, r, r, parallel ) ) )/b_norm;
+
+      while( result.residual > settings.tolerance && result.iterations < settings.max_iterations )
+      {
+          const _Ty rho_next = detail::solver_dot( ws, n, r0, r, parallel );
+          if( rho_next == _Ty(0) || omega == _Ty(0) ) {
+              break;
+          }
+          // p = r + beta*( p - omega*v )
+          detail::solver_axpy( n, -omega, v, p, parallel );
+          detail::solver_xpby( n, r, ( rho_next/rho )*( alpha/omega ), p, parallel );
+          m.apply( p, y );
+          op( y, v );
+          alpha = rho_next/detail::solver_dot( ws, n, r0, v, parallel );
+          std::copy( r, r + n, s );
+          detail::solver_axpy( n, -alpha, v, s, parallel );
+          detail::solver_axpy( n, alpha, y, x.data(), parallel );
+          result.iterations++;
+          const double s_norm = std::sqrt( double( detail::solver_dot( ws, n, s, s, parallel ) ) )/b_norm;
+          if( s_norm <= settings.tolerance ) {
+              result.residual = s_norm;
+              break;
+          }
+          m.apply( s, z );
+          op( z, t );
+          const _Ty tt = detail::solver_dot( ws, n, t, t, parallel );
+          omega = tt == _Ty(0) ? _Ty(0) : detail::solver_dot( ws, n, t, s, parallel )/tt;
+          detail::solver_axpy( n, omega, z, x.data(), parallel );
+          std::copy( s, s + n, r );
+          detail::solver_axpy( n, -omega, t, r, parallel );
+          rho = rho_next;
+          result.residual = std::sqrt( double( detail::solver_dot( ws, n, r, r, parallel ) ) )/b_norm;
+      }
+      result.converged = result.residual <= settings.tolerance;
+      return result;
+    }
+
+template<
+    typename _Ty,
+    class _OpTy,
+    class _PrecondTy>
+    solver_result bicgstab( _OpTy const& a, std::vector<_Ty> const& b, std::vector<_Ty> & x,
+                            _PrecondTy const& m, solver_settings const& settings = {} )
+    {
+      local_lease<solver_workspace<_Ty> > ws;
+      return bicgstab( a, b, x, m, settings, *ws );
+    }
+
+template<
+    typename _Ty,
+    class _OpTy>
+    solver_result bicgstab( _OpTy const& a, std::vector<_Ty> const& b, std::vector<_Ty> & x,
+                            solver_settings const& settings = {} ) {
+      return bicgstab( a, b, x, identity_preconditioner<_Ty>{ b.size() }, settings );
+    }
+// x += D^-1*( b - A*x ) until the residual is small, converges for a diagonally dominant A
+template<
+    typename _Ty,
+    class _OpTy>
+    solver_result jacobi( _OpTy const& a, std::vector<_Ty> const& b, std::vector<_Ty> & x,
+                          jacobi_preconditioner<_Ty> const& d, solver_settings const& settings,
+                          solver_workspace<_Ty> & ws )
+    {
+      detail::solver_check( b, x, "<tvd::jacobi>" );
+      detail::solver_check( d, b.size(), "<tvd::jacobi>" );
+      const size_t n = b.size();
+      auto const& op = linear_operator( a, n );
+      const bool   parallel = settings.parallel;
+      _Ty *r = ws.get( 0, n );
+
+      solver_result result;
+      const double b_norm = std::sqrt( double( detail::solver_dot( ws, n, b.data(), b.data(), parallel ) ) );
+      if( b_norm == 0 ) {
+          std::fill( x.begin(), x.end(), _Ty(0) );
+          result.converged = true;
+          return result;
+      }
+      const _Ty *inverse = d.inverse();
+      for( ;; )
+      {
+          op( x.data(), r );
+          detail::solver_residual( n, b.data(), r, parallel );
+          result.residual = std::sqrt( double( detail::solver_dot( ws, n, r, r, parallel ) ) )/b_norm;
+          if( result.residual <= settings.tolerance || result.iterations == settings.max_iterations ) {
+              break;
+          }
+          detail::solver_for( n, parallel, [&]( size_t first, size_t last ) {
+            for( size_t i(first); i < last; i++ ) {
+                x[i] += inverse[i]*r[i];
+            }
+          } );
+          result.iterations++;
+      }
+      result.converged = result.residual <= settings.tolerance;
+      return result;
+    }
+
+template<
+    typename _Ty,
+    class _OpTy>
+    solver_result jacobi( _OpTy const& a, std::vector<_Ty> const& b, std::vector<_Ty> & x,
+                          jacobi_preconditioner<_Ty> const& d, solver_settings const& settings = {} )
+    {
+      local_lease<solver_workspace<_Ty> > ws;
+      return jacobi( a, b, x, d, settings, *ws );
+    }
+} // tvd
+#endif
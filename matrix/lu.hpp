@@ -0,0 +1,227 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the LU decomposition
+#pragma once
+#ifndef TVD_MATRIX_LU_HPP
+#define TVD_MATRIX_LU_HPP
+
+#include "tvd/exception.hpp"
+#include "tvd/matrix/gemm.hpp"
+#include "tvd/matrix/matrix.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+namespace tvd {
+
+    namespace detail {
+      // panel width of the blocked factorization and of the triangular solves
+      inline constexpr size_t lu_block = 64;
+
+      // X[n x m] := L^-1 X, L unit lower triangular; the rows above a block are folded in by one gemm
+  template<typename _Ty>
+      void trsm_lower_unit( size_t n, size_t m, const _Ty *l, ptrdiff_t ldl, _Ty *x, ptrdiff_t ldx )
+      {
+        for( size_t k0(0); k0 < n; k0 += lu_block )
+        {
+            const size_t k1 = std::min( n, k0 + lu_block );
+            gemm<_Ty>( k1 - k0, m, k0, _Ty(-1), l + k0*ldl, ldl, 1, x, ldx, 1, x + k0*ldx, ldx, 1 );
+            for( size_t i(k0); i < k1; i++ ) {
+                for( size_t r(k0); r < i; r++ )
+                {
+                    const _Ty l_ir = l[i*ldl + r];
+                    for( size_t j(0); j < m; j++ ) {
+                        x[i*ldx + j] -= l_ir*x[r*ldx + j];
+                    }
+                }
+            }
+        }
+      }
+      // X[n x m] := U^-1 X, U upper triangular, bottom block first
+  template<typename _Ty>
+      void trsm_upper( size_t n, size_t m, const _Ty *u, ptrdiff_t ldu, _Ty *x, ptrdiff_t ldx )
+      {
+        for( size_t k1(n); k1 > 0; )
+        {
+            const size_t k0 = k1 > lu_block ? k1 - lu_block : 0;
+            gemm<_Ty>( k1 - k0, m, n - k1, _Ty(-1), u + k0*ldu + k1, ldu, 1, x + k1*ldx, ldx, 1, x + k0*ldx, ldx, 1 );
+            for( size_t i(k1); i-- > k0; )
+            {
+                for( size_t r(i + 1); r < k1; r++ )
+                {
+                    const _Ty u_ir = u[i*ldu + r];
+                    for( size_t j(0); j < m; j++ ) {
+                        x[i*ldx + j] -= u_ir*x[r*ldx + j];
+                    }
+                }
+                const _Ty u_ii = u[i*ldu + i];
+                for( size_t j(0); j < m; j++ ) {
+                    x[i*ldx + j] /= u_ii;
+                }
+            }
+            k1 = k0;
+        }
+      }
+      // right-looking blocked LU of the row-major A[n x n] in place : L below the diagonal with a unit diagonal
+      // left implicit, U on and above it. the pivot rows are swapped whole, row i of the result is the row
+      // perm[i] of A. every block : an unblocked panel with partial pivoting, U12 := L11^-1 A12 and the trailing
+      // update A22 -= L21*U12 through gemm. returns the sign of the permutation, 0 when a pivot is zero
+  template<typename _Ty>
+      int lu_factor( size_t n, _Ty *a, ptrdiff_t lda, size_t *perm )
+      {
+        std::iota( perm, perm + n, size_t(0) );
+        int sign = 1;
+        bool singular = false;
+        for( size_t k0(0); k0 < n; k0 += lu_block )
+        {
+            const size_t k1 = std::min( n, k0 + lu_block );
+            for( size_t j(k0); j < k1; j++ )
+            {
+                size_t p = j;
+                for( size_t i(j + 1); i < n; i++ ) {
+                    if( std::abs( a[i*lda + j] ) > std::abs( a[p*lda + j] ) ) {
+                        p = i;
+                    }
+                }
+                if( p != j ) {
+                    std::swap_ranges( a + j*lda, a + j*lda + n, a + p*lda );
+                    std::swap( perm[j], perm[p] );
+                    sign = -sign;
+                }
+                const _Ty pivot = a[j*lda + j];
+                if( pivot == _Ty(0) ) {
+                    singular = true;
+                    continue;
+                }
+                const _Ty *u_row = a + j*lda;
+                for( size_t i(j + 1); i < n; i++ )
+                {
+                    _Ty *row = a + i*lda;
+                    const _Ty l_ij = row[j] /= pivot;
+                    for( size_t c(j + 1); c < k1; c++ ) {
+                        row[c] -= l_ij*u_row[c];
+                    }
+                }
+            }
+            if( k1 < n )
+            {
+                trsm_lower_unit( k1 - k0, n - k1, a + k0*lda + k0, lda, a + k0*lda + k1, lda );
+                gemm<_Ty>( n - k1, n - k1, k1 - k0, _Ty(-1),
+                           a + k1*lda + k0, lda, 1,
+                           a + k0*lda + k1, lda, 1,
+                           a + k1*lda + k1, lda, 1 );
+            }
+        }
+        return singular ? 0 : sign;
+      }
+    } // detail
+// P*A = L*U in one matrix : L strictly below the diagonal (its unit diagonal is implied), U on and above it;
+// row i of <lu> is the row perm[i] of A
+template<class _MatrixTy>
+    struct lu_factors
+    {
+      _MatrixTy           lu;
+      std::vector<size_t> perm;
+      int                 sign;  // of the permutation, 0 for a singular matrix
+
+      bool singular() const noexcept {
+        return sign == 0;
+      }
+    };
+// factors <A> in place, pass it as an rvalue to skip the copy
+template<
+    typename _Ty,
+    size_t size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    lu_factors<matrix<_Ty, size, _ElemTraitsTy, _AllocTy> > lu_factor( matrix<_Ty, size, _ElemTraitsTy, _AllocTy> A )
+    {
+      if( A.size() != size ) {
+          throw TVD_EXCEPTION( "<tvd::lu_factor> : <matrix.size> != <matrix.csize>" );
+      }
+      lu_factors<matrix<_Ty, size, _ElemTraitsTy, _AllocTy> > f{ std::move( A ), std::vector<size_t>( size ), 1 };
+      f.sign = detail::lu_factor( size, f.lu.data(), size, f.perm.data() );
+      return f;
+    }
+// solves A*X = B for every column of <B> in place
+template<
+    typename _Ty,
+    size_t size,
+    typename _ElemTraitsTy,
+    typename _AllocTy,
+    size_t rhs,
+    typename _RhsTraitsTy,
+    typename _RhsAllocTy>
+    void lu_solve( lu_factors<matrix<_Ty, size, _ElemTraitsTy, _AllocTy> > const& f,
+                   matrix<_Ty, rhs, _RhsTraitsTy, _RhsAllocTy> & B )
+    {
+      if( f.singular() ) {
+          throw TVD_EXCEPTION( "<tvd::lu_solve> : singular matrix" );
+      }
+      if( B.size() != size ) {
+          throw TVD_EXCEPTION( "<tvd::lu_solve> : <B.size> != <A.size>" );
+      }
+      matrix<_Ty, rhs, _RhsTraitsTy, _RhsAllocTy> X( size, B.get_allocator() );
+      for( size_t i(0); i < size; i++ ) {
+          std::copy_n( B.data() + f.perm[i]*rhs, rhs, X.data() + i*rhs );
+      }
+      detail::trsm_lower_unit( size, rhs, f.lu.data(), size, X.data(), rhs );
+      detail::trsm_upper( size, rhs, f.lu.data(), size, X.data(), rhs );
+      B = std::move( X );
+    }
+
+template<
+    typename _Ty,
+    size_t size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    void lu_solve( lu_factors<matrix<_Ty, size, _ElemTraitsTy, _AllocTy> > const& f, vector<_Ty, size> & b )
+    {
+      matrix<_Ty, 1> B( size );
+      for( size_t i(0); i < size; i++ ) {
+          B.data()[i] = b[i];
+      }
+      lu_solve( f, B );
+      for( size_t i(0); i < size; i++ ) {
+          b[i] = B.data()[i];
+      }
+    }
+// throws for a singular matrix
+template<
+    typename _Ty,
+    size_t size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    matrix<_Ty, size, _ElemTraitsTy, _AllocTy> inverse( matrix<_Ty, size, _ElemTraitsTy, _AllocTy> A )
+    {
+      const auto f = lu_factor( std::move( A ) );
+      if( f.singular() ) {
+          throw TVD_EXCEPTION( "<tvd::inverse> : singular matrix" );
+      }
+      matrix<_Ty, size, _ElemTraitsTy, _AllocTy> I( size, f.lu.get_allocator() );
+      std::fill( I.begin(), I.end(), _Ty(0) );
+      for( size_t i(0); i < size; i++ ) {
+          I.data()[i*size + i] = _Ty(1);
+      }
+      lu_solve( f, I );
+      return I;
+    }
+
+template<
+    typename _Ty,
+    size_t size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    _Ty determinant( matrix<_Ty, size, _ElemTraitsTy, _AllocTy> A )
+    {
+      const auto f = lu_factor( std::move( A ) );
+      _Ty det = _Ty( f.sign );
+      for( size_t i(0); i < size && det != _Ty(0); i++ ) {
+          det *= f.lu.data()[i*size + i];
+      }
+      return det;
+    }
+} // tvd
+#endif
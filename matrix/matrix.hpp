@@ -4,17 +4,17 @@
 #ifndef TVD_MATRIX_MATRIX_HPP
 #define TVD_MATRIX_MATRIX_HPP
 
+#include "tvd/allocator.hpp"
 #include "tvd/base_mixing_templates.hpp"
+#include "tvd/scratch_arena.hpp"
 #include "tvd/type_traits.hpp"
+#include "tvd/matrix/gemm.hpp"
+#include "tvd/matrix/row_ref.hpp"
+#include "tvd/matrix/simd.hpp"
+#include <array>
 #include <vector>
 
 namespace tvd {
-
-template<
-    typename _Ty,
-    size_t,
-    typename = elem_traits<typename std::remove_pointer<_Ty>::type> >
-    class vector;
 // vector mixing
 template<
     typename _Ty,
@@ -57,20 +57,13 @@ private :
       typename elem_container_t::container_t container_;
 public :
 
-      vector()
-        : vec_mixing_list_t<_Ty, col_size, _ElemTraitsTy>()
-      {
-      }
-
-      vector( vector const& other )
-        : container_( other.container_ )
-      {
-      }
-
-      vector( vector && other ) noexcept
-        : container_( std::move( other.container_ ) )
+      constexpr vector() noexcept
+        : container_{}
       {
       }
+      // copies are plain element copies, vectors of values are trivially copyable
+      vector( vector const& other ) = default;
+      vector( vector && other ) noexcept = default;
 
   template<
       typename _EnableTy = _Ty,
@@ -100,7 +93,7 @@ public :
         }
       }
 
-      vector( init_list_t list )
+      constexpr vector( init_list_t list )
         : vector()
       {
         if( col_size < list.size() ) {
@@ -109,40 +102,45 @@ public :
         size_t j( 0 );
         for( auto const& col : list ) {
             container_[j++] = col;
-	}
+        }
+      }
+      // evaluates <a + b - c*k> in one pass
+  template<
+      class _ExprTy,
+      is_expression_of_t<_ExprTy, vector> = true>
+      vector( _ExprTy const& expr )
+        : vector()
+      {
+        *this = expr;
       }
 
-      bool empty() const noexcept {
+      constexpr bool empty() const noexcept {
         return container_.empty();
       }
 
-      pointer_t data() noexcept {
+      constexpr pointer_t data() noexcept {
         return container_.data();
       }
 
-      const_pointer_t data() const noexcept {
+      constexpr const_pointer_t data() const noexcept {
         return container_.data();
       }
 
-      size_t size() const noexcept {
+      constexpr size_t size() const noexcept {
         return col_size;
       }
 
-      vector & operator = ( vector const& other )
-      {
-        if( this == &other ) {
-            return *this;
-        }
-        container_ = other.container_;
-        return *this;
-      }
+      vector & operator = ( vector const& other ) = default;
+      vector & operator = ( vector && other ) noexcept = default;
 
-      vector & operator = ( vector && other ) noexcept
+  template<
+      class _ExprTy,
+      is_expression_of_t<_ExprTy, vector> = true>
+      vector & operator = ( _ExprTy const& expr )
       {
-        if( this == &other ) {
-            return *this;
+        for( size_t i(0); i < col_size; i++ ) {
+            container_[i] = expr.eval( i );
         }
-        container_ = std::move( other.container_ );
         return *this;
       }
 
@@ -150,7 +148,7 @@ public :
       typename Ty,
       typename _EnableTy = _Ty,
       is_pointer_t<_EnableTy> = true>
-      operator vector<Ty, col_size> ()
+      operator vector<Ty, col_size> () const
       {
         vector<Ty, col_size> vector;
         for( size_t i(0); i < col_size; i++ ) {
@@ -159,7 +157,7 @@ public :
         return vector;
       }
 
-      bool operator == ( vector<pointer_t, col_size> const& other )
+      constexpr bool operator == ( vector<pointer_t, col_size> const& other ) const
       {
         if( col_size != other.size() ) {
             return false;
@@ -179,7 +177,7 @@ public :
         return true;
       }
 
-      bool operator == ( vector<type_t, col_size> const& other )
+      constexpr bool operator == ( vector<type_t, col_size> const& other ) const
       {
         if( col_size != other.size() ) {
             return false;
@@ -214,6 +212,10 @@ public :
 
       vector & operator += ( vector<type_t, col_size> const& other )
       {
+        if constexpr( !std::is_pointer_v<_Ty> && col_size >= simd::min_size ) {
+            simd::add( container_.data(), other.data(), col_size );
+            return *this;
+        }
         for( size_t i(0); i < col_size; i++ )
         {
             if constexpr ( std::is_pointer_v<_Ty> ) {
@@ -240,6 +242,10 @@ public :
 
       vector & operator -= ( vector<type_t, col_size> const& other )
       {
+        if constexpr( !std::is_pointer_v<_Ty> && col_size >= simd::min_size ) {
+            simd::sub( container_.data(), other.data(), col_size );
+            return *this;
+        }
         for( size_t i(0); i < col_size; i++ )
         {
             if constexpr( std::is_pointer_v<_Ty> ) {
@@ -253,18 +259,22 @@ public :
 
       vector & operator *= ( type_t const& value )
       {
+        if constexpr( !std::is_pointer_v<_Ty> && col_size >= simd::min_size ) {
+            simd::scale( container_.data(), value, col_size );
+            return *this;
+        }
         for( auto & it : container_ )
         {
             if constexpr ( std::is_pointer_v<_Ty> ) {
-             ( *it ) += value;
+             ( *it ) *= value;
             } else {
-                it += value;
+                it *= value;
             }
         }
         return *this;
       }
 
-      reference_t operator [] ( size_t const& j )
+      constexpr reference_t operator [] ( size_t const& j )
       {
         if( j >= col_size ) {
             throw TVD_EXCEPTION( "<vector::operator[]> : bad access" );
@@ -276,7 +286,7 @@ public :
         }
       }
 
-      type_t operator [] ( size_t const& j ) const
+      constexpr type_t operator [] ( size_t const& j ) const
       {
         if( j >= col_size ) {
             throw TVD_EXCEPTION( "<vector::operator[] const> : bad access" );
@@ -291,21 +301,23 @@ public :
 // matrix mixing list
 template<
     typename _MatrixTy,
-    typename _ElemTraitsTy>
+    typename _ElemTraitsTy,
+    typename _AllocTy>
     using mtx_mixing_list_t = mixing_list
     <
-      add_iterators< _MatrixTy, elem_container<_ElemTraitsTy, std::vector<typename _ElemTraitsTy::type_t> > >,
+      add_iterators< _MatrixTy, elem_container<_ElemTraitsTy, std::vector<typename _ElemTraitsTy::type_t, _AllocTy> > >,
       add_non_equalable< _MatrixTy >,
       add_sum< _MatrixTy >,
       add_difference< _MatrixTy >,
       add_division_by_value< _MatrixTy, _ElemTraitsTy >
     >;
-// matrix container
+// matrix container, <_AllocTy> is the storage policy : aligned_allocator, huge_page_allocator or any std allocator
 template<
     typename _Ty = float,
     size_t col_size = 3,
-    typename _ElemTraitsTy = elem_traits<_Ty> >
-    class matrix final : public mtx_mixing_list_t<matrix<_Ty, col_size>, _ElemTraitsTy>
+    typename _ElemTraitsTy = elem_traits<_Ty>,
+    typename _AllocTy = aligned_allocator<_Ty> >
+    class matrix final : public mtx_mixing_list_t<matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy>, _ElemTraitsTy, _AllocTy>
     {
       static_assert(
         !std::is_pointer_v<_Ty>,
@@ -317,12 +329,15 @@ template<
         "< tvd::matrix<_Ty, size_t> > : <col_size> == <0>"
       );
 
-      using elem_container_t = elem_container< elem_traits<_Ty>, std::vector<_Ty> >;
+      using mixing_list_t    = mtx_mixing_list_t<matrix, _ElemTraitsTy, _AllocTy>;
+      using elem_container_t = elem_container< elem_traits<_Ty>, std::vector<_Ty, _AllocTy> >;
       friend struct access<elem_container_t>;
       friend class  vector<_Ty*, col_size>;
 public :
-      using add_multiplying_by_value<matrix<_Ty, col_size>, _ElemTraitsTy>::operator*;
+      using allocator_t      = _AllocTy;
       using ptrs_vector_t    = vector<_Ty*, col_size>;
+      using row_t            = row_ref<_Ty, col_size>;
+      using const_row_t      = row_ref<const _Ty, col_size>;
       using vector_t         = vector<_Ty, col_size>;
       using type_t           = typename _ElemTraitsTy::type_t;
       using pointer_t        = typename _ElemTraitsTy::pointer_t;
@@ -347,13 +362,19 @@ public :
       }
 
       explicit matrix( size_t const& size )
-        : mtx_mixing_list_t<matrix<_Ty, col_size>, _ElemTraitsTy>()
+        : mixing_list_t()
         , container_( size*col_size )
       {
       }
 
+      matrix( size_t const& size, allocator_t const& allocator )
+        : mixing_list_t()
+        , container_( size*col_size, allocator )
+      {
+      }
+
       matrix( init_list_t<> list )
-        : mtx_mixing_list_t<matrix<_Ty, col_size>, _ElemTraitsTy>()
+        : mixing_list_t()
         , container_( list.size() )
       {
         if( col_size > list.size() || list.size()%col_size != 0 ) {
@@ -363,7 +384,7 @@ public :
       }
 
       matrix( init_list_t<vector_t> list )
-        : mtx_mixing_list_t<matrix<_Ty, col_size>, _ElemTraitsTy>()
+        : mixing_list_t()
         , container_( list.size() )
       {
         if( col_size > list.size() || list.size()%col_size != 0 ) {
@@ -373,6 +394,15 @@ public :
             insert( vector );
         }
       }
+      // evaluates <a + b - c*k> in one pass with a single allocation, from the allocator of the leftmost operand
+  template<
+      class _ExprTy,
+      is_expression_of_t<_ExprTy, matrix> = true>
+      matrix( _ExprTy const& expr )
+        : mixing_list_t()
+        , container_( expr.begin(), expr.end(), expr.leaf().get_allocator() )
+      {
+      }
 
       bool empty() const noexcept {
         return container_.empty();
@@ -390,6 +420,10 @@ public :
         return container_.size()/col_size;
       }
 
+      allocator_t get_allocator() const {
+        return access<elem_container_t>::get_allocator( this );
+      }
+
       size_t csize() const noexcept {
         return col_size;
       }
@@ -399,9 +433,6 @@ public :
         if( size == this->size() ) {
             return;
         }
-        if( size%col_size != 0 ) {
-            throw TVD_EXCEPTION( "<matrix::resize> : bad new size, <size>%<col_size> != <0>" );
-        }
         container_.resize( size*col_size );
       }
 
@@ -430,45 +461,59 @@ public :
         container_.erase( it, it + col_size );
       }
       // overloads
-      bool operator == ( matrix const& other ) {
+      bool operator == ( matrix const& other ) const {
         return container_ == other.container_;
       }
 
       matrix & operator += ( matrix const& other )
       {
-        for( size_t i(0); i < container_.size(); i++ ) {
-            container_[i] += other.container_[i];
+        if( container_.size() != other.container_.size() ) {
+            throw TVD_EXCEPTION( "<matrix::operator+=> : <size> != <other.size>" );
         }
+        simd::add( container_.data(), other.container_.data(), container_.size() );
         return *this;
       }
 
       matrix & operator -= ( matrix const& other )
       {
-        for( size_t i(0); i < container_.size(); i++ ) {
-            container_[i] -= other.container_[i];
+        if( container_.size() != other.container_.size() ) {
+            throw TVD_EXCEPTION( "<matrix::operator-=> : <size> != <other.size>" );
         }
+        simd::sub( container_.data(), other.container_.data(), container_.size() );
         return *this;
       }
 
       matrix & operator *= ( _Ty const& value )
       {
-        for( auto & elem : container_ ) {
-            elem *= value;
-        }
+        simd::scale( container_.data(), value, container_.size() );
         return *this;
       }
 
-      matrix & operator *= ( matrix const& other )
+      // a product that fits one arena chunk is accumulated in the thread's scratch arena, a larger one in
+      // an ordinary temporary, since the arena keeps every chunk it grows until the thread exits
+  template<typename _OtherAllocTy>
+      matrix & operator *= ( matrix<_Ty, col_size, _ElemTraitsTy, _OtherAllocTy> const& other )
       {
-        matrix r( size() );
-        multiply( r.data(), other );
-        std::copy( r.begin(), r.end(), container_.begin() );
+        const size_t n = container_.size();
+        if( n*sizeof(_Ty) > scratch_arena::min_chunk ) {
+            typename elem_container_t::container_t r( n, _Ty(0), container_.get_allocator() );
+            multiply( r.data(), other );
+            std::copy( r.begin(), r.end(), container_.begin() );
+            return *this;
+        }
+        scratch_scope scope;
+        _Ty *r = scratch_arena::local().allocate<_Ty>( n );
+        std::fill( r, r + n, _Ty(0) );
+        multiply( r, other );
+        std::copy( r, r + n, container_.begin() );
         return *this;
       }
 
-  template<size_t col_size_>
-      matrix<_Ty, col_size_> operator * ( matrix<_Ty, col_size_> const& other ) {
-        matrix<_Ty, col_size_> r( size() );
+  template<
+      size_t col_size_,
+      typename _OtherAllocTy>
+      matrix<_Ty, col_size_, _ElemTraitsTy, _AllocTy> operator * ( matrix<_Ty, col_size_, _ElemTraitsTy, _OtherAllocTy> const& other ) const {
+        matrix<_Ty, col_size_, _ElemTraitsTy, _AllocTy> r( size(), get_allocator() );
         multiply( r.data(), other );
         return r;
       }
@@ -486,6 +531,23 @@ public :
         container_ = std::move( other.container_ );
         return *this;
       }
+      // reuses the storage when the size matches, the expression may refer to *this
+  template<
+      class _ExprTy,
+      is_expression_of_t<_ExprTy, matrix> = true>
+      matrix & operator = ( _ExprTy const& expr )
+      {
+        if( container_.size() != expr.extent() ) {
+            typename elem_container_t::container_t container( expr.begin(), expr.end(), container_.get_allocator() );
+            container_.swap( container );
+            return *this;
+        }
+        auto data = container_.data();
+        for( size_t i(0); i < container_.size(); i++ ) {
+            data[i] = expr.eval( i );
+        }
+        return *this;
+      }
 
       matrix & operator = ( init_list_t<> list )
       {
@@ -507,25 +569,29 @@ public :
         return *this;
       }
 
-      ptrs_vector_t operator [] ( size_t const& i )
+      // rows are referenced in place, only the row index is checked
+      row_t operator [] ( size_t const& i )
       {
-        if( i >= std::size( container_ ) ) {
-            throw TVD_EXCEPTION( "<matrix::operator[]> : <i> >= <col_size> | <matrix> is empty" );
+        if( i >= size() ) {
+            throw TVD_EXCEPTION( "<matrix::operator[]> : <i> >= <size> | <matrix> is empty" );
         }
-        return vector<_Ty*, col_size>( *this, i );
+        return row_t( container_.data() + i*col_size );
       }
 
-      const ptrs_vector_t operator [] ( size_t const& i ) const
+      const_row_t operator [] ( size_t const& i ) const
       {
-        if( i >= std::size( container_ ) ) {
-            throw TVD_EXCEPTION( "<matrix> : <i> >= <col_size> | <matrix> is empty" );
+        if( i >= size() ) {
+            throw TVD_EXCEPTION( "<matrix::operator[] const> : <i> >= <size> | <matrix> is empty" );
         }
-        return vector<_Ty*, col_size>( *this, i );
+        return const_row_t( container_.data() + i*col_size );
       }
 private :
 
-  template<size_t col_size_>
-      void multiply( _Ty *r, matrix<_Ty, col_size_> const& m )
+      // r += (*this)*m, <r> must hold size()*col_size_ elements
+  template<
+      size_t col_size_,
+      typename _OtherAllocTy>
+      void multiply( _Ty *r, matrix<_Ty, col_size_, _ElemTraitsTy, _OtherAllocTy> const& m ) const
       {
         if constexpr( std::is_pointer_v<_Ty> ) {
             static_assert(
@@ -536,19 +602,49 @@ private :
         if( col_size != std::size( m ) ) {
             throw TVD_EXCEPTION( "<matrix::multiply> : col1 != row2" );
         }
-        auto m_ = m.data();
-        for( size_t i(0); i < std::size( container_ ); i++ )
-        {
-            for( size_t j(0); j < col_size_; j++ ) 
-            {
-                for( size_t k(0); k < col_size; k++ ) 
-                {
-                    r[i*col_size_ + j] += container_[i*col_size + k]*m_[k*col_size_ + j];
-                }
-            }
-        }
+        detail::gemm<_Ty>( size(), col_size_, col_size, _Ty(1),
+                           container_.data(), col_size,  1,
+                           m.data(),          col_size_, 1,
+                           r,                 col_size_, 1 );
       }
     }; // end matrix container
+// expression operands
+template<
+    typename _Ty,
+    size_t col_size,
+    typename _ElemTraitsTy>
+    struct expression_traits< vector<_Ty, col_size, _ElemTraitsTy> >
+    {
+      using result_t = vector<typename _ElemTraitsTy::type_t, col_size>;
+      using type_t   = typename _ElemTraitsTy::type_t;
+
+      static size_t extent( vector<_Ty, col_size, _ElemTraitsTy> const& ) {
+        return col_size;
+      }
+
+      static type_t eval( vector<_Ty, col_size, _ElemTraitsTy> const& v, size_t i ) {
+        return v[i];
+      }
+    };
+
+template<
+    typename _Ty,
+    size_t col_size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    struct expression_traits< matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> >
+    {
+      using result_t = matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy>;
+      using type_t   = typename _ElemTraitsTy::type_t;
+
+      static size_t extent( result_t const& m ) {
+        return m.size()*col_size;
+      }
+
+      static type_t eval( result_t const& m, size_t i ) {
+        return m.data()[i];
+      }
+    };
 
     // deduction guide
 template<
@@ -569,6 +665,11 @@ template<
       using matrix_3xn_t = matrix<_Ty, 3>;
   template<typename _Ty>
       using matrix_4xn_t = matrix<_Ty, 4>;
+      // matrix for temporaries, lives in the thread's scratch arena, see scratch_scope
+  template<
+      typename _Ty,
+      size_t col_size>
+      using scratch_matrix_t = matrix<_Ty, col_size, elem_traits<_Ty>, scratch_allocator<_Ty> >;
       // vector with 2/3/4 elements
   template<typename _Ty>
       using vector2_t = vector<_Ty, 2>;
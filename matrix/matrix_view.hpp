@@ -4,13 +4,18 @@
 
 #include "tvd/base_mixing_templates.hpp"
 #include "tvd/type_traits.hpp"
+#include "tvd/matrix/matrix.hpp"
+#include "tvd/matrix/row_ref.hpp"
 
-#include <iostream>
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <vector>
 
 namespace tvd {
 
 template<
-    typename _Ty = float, 
+    typename _Ty = float,
     class _ElemTraitsTy = elem_traits<_Ty> >
     class matrix_view;
 
@@ -20,7 +25,8 @@ template<
       using mtx_v_mixing_list_t = mixing_list<
       add_non_equalable<_MatrixTy>
     >;
-
+// read-only pointer plus shape over a row-major buffer owned elsewhere, copying it copies three words;
+// the buffer must outlive the view, see shared_matrix_view for a view that keeps it alive
 template<
     typename _Ty,
     class _ElemTraitsTy>
@@ -30,127 +36,62 @@ template<
         !std::is_pointer_v<_Ty>,
         "tvd::matrix_view<_Ty> : no specialization of class for pointer"
       );
-
-      struct do_nothing_deleter
-      {
-    template<typename>
-        void operator()(_Ty*) { }
-      };
-
-  template<typename Ty>
-      class iterator : public std::iterator<std::input_iterator_tag, Ty>
-      {
-        friend class matrix_view<Ty>;
-        Ty* p_;
-  public :
-        iterator(iterator const& it)
-          : p_(it.p_)
-        {
-        }
-
-        bool operator == (iterator const& right) const {
-          return p_ == right.p_;
-        }
-
-        bool operator != (iterator const& right) const {
-          return p_ != right.p_;
-        }
-
-        typename iterator::reference operator*() const {
-          return *p_;
-        }
-	
-        iterator& operator++() {
-          ++p_;
-          return *this;
-        }
-  private :
-        iterator(Ty *p)
-          : p_(p)
-        {
-        }
-      };
-
 public :
-      using add_non_equalable<matrix_view<_Ty> >::operator!=;
       using type_t            = typename _ElemTraitsTy::type_t;
       using const_pointer_t   = const type_t*;
-      using const_iterator_t  = const iterator<_Ty>;
+      using const_iterator_t  = const_pointer_t;
+      using const_row_t       = row_ref<const type_t>;
       using vector_t          = std::vector<type_t>;
 private :
-      const size_t size_;
-      const size_t col_size_;
-      std::shared_ptr<type_t[]> array_;
+      const_pointer_t array_;
+      size_t size_;
+      size_t col_size_;
 public :
 
-      matrix_view()
-        : mtx_v_mixing_list_t<matrix_view<_Ty>, _ElemTraitsTy>()
+      constexpr matrix_view() noexcept
+        : array_(nullptr)
         , size_(0)
         , col_size_(0)
-        , array_(nullptr)
       {
       }
 
   template<typename MatrixTy>
       explicit matrix_view( MatrixTy const& m )
-        : mtx_v_mixing_list_t<matrix_view<_Ty>, _ElemTraitsTy>()
+        : array_( m.data() )
         , size_( m.size() )
         , col_size_( m.csize() )
-        , array_( m.data(), do_nothing_deleter() )
       {
         if( (col_size_ || size_) == 0) {
             throw TVD_EXCEPTION( "<matrix_view::matrix_view> : <m.size()> == <0>)" );
         }
       }
-      // std::default_delete<_Ty[]>()
-      matrix_view( std::shared_ptr<type_t[]> const& array, size_t size, size_t col_size = 3 )
-        : mtx_v_mixing_list_t<matrix_view<_Ty>, _ElemTraitsTy>()
+
+      matrix_view( const_pointer_t array, size_t size, size_t col_size = 3 )
+        : array_( array )
         , size_(size)
         , col_size_(col_size)
-        , array_( array )
       {
         if( (col_size || size) == 0) {
             throw TVD_EXCEPTION( "<matrix_view::matrix_view> : (<col_size> || <size>) == <0>)" );
         }
       }
 
-      matrix_view( matrix_view const& other )
-      {
-        if( array_ == other.array_ ) return;
-        array_ = other.array_;
-      }
-
-      matrix_view( matrix_view && other )
-      {
-        if( array_ == other.array_ ) return;
-        array_ = std::move( other.array_ );
-      }
-
-      matrix_view & operator = ( matrix_view const& other )
-      {
-        if( array_ == other.array_ ) return *this;
-        array_ = other.array_;
-      }
-
-      matrix_view & operator = ( matrix_view && other )
-      {
-        if( array_ == other.array_ ) return *this;
-        array_ = std::move( other.array_ );
-      }
+      matrix_view( matrix_view const& other ) = default;
+      matrix_view & operator = ( matrix_view const& other ) = default;
 
-      const_pointer_t begin() const {
-        return const_pointer_t(array_);
+      const_pointer_t begin() const noexcept {
+        return array_;
       }
 
-      const_pointer_t end() const {
-        return const_pointer_t(array_ + size_*col_size_);
+      const_pointer_t end() const noexcept {
+        return array_ + size_*col_size_;
       }
 
-      const_pointer_t cbegin() const {
+      const_pointer_t cbegin() const noexcept {
         return begin();
       }
 
-      const_pointer_t cend() const {
+      const_pointer_t cend() const noexcept {
         return end();
       }
 
@@ -158,6 +99,10 @@ public :
         return array_;
       }
 
+      bool empty() const noexcept {
+        return size_*col_size_ == 0;
+      }
+
       size_t size() const noexcept {
         return size_;
       }
@@ -166,45 +111,86 @@ public :
         return col_size_;
       }
       // overloads
-      bool operator == (matrix_view<_Ty> const& right) {
-        if(size_ != right.size_) {
+      bool operator == (matrix_view const& right) const {
+        if(size_ != right.size_ || col_size_ != right.col_size_) {
             return false;
         }
-        for(size_t i = 0; i < size_; i++)
-            if(array_[i] != right.array_[i]) {
-                return false;
-            }
-        return true;
+        return std::equal( begin(), end(), right.begin() );
       }
 
   template<size_t size>
-      bool operator == (matrix<_Ty, size> const& right) {
-        if(size_ != right.size()) {
+      bool operator == (matrix<_Ty, size> const& right) const {
+        if(size_ != right.size() || col_size_ != size) {
             return false;
         }
-        const auto *array = right.data();
-        for(size_t i = 0; i < size; i++)
-            if(array_[i] != array[i]) {
-                return false;
-            }
-        return true;
+        return std::equal( begin(), end(), right.data() );
       }
 
   template<size_t size>
-      bool operator != (matrix<_Ty, size> const& right) {
+      bool operator != (matrix<_Ty, size> const& right) const {
         return !(*this == right);
       }
-
-      vector_t operator [] (size_t const& i) const {
-        if(i >= size_*col_size_) {
-            throw TVD_EXCEPTION("matrix : i >= col_size | matrix is empty");
-        }
-        vector_t vector(col_size_);
-        for(size_t j = i*col_size_, k = 0; j < col_size_ *(i + 1); j++, k++) {
-            vector[k] = array_[j];
+      // the row is referenced in place, only the row index is checked
+      const_row_t operator [] (size_t const& i) const {
+        if(i >= size_) {
+            throw TVD_EXCEPTION("<matrix_view::operator[]> : <i> >= <size> | <matrix_view> is empty");
         }
-        return vector;
+        return const_row_t( array_ + i*col_size_, col_size_ );
       }
     };
+// matrix_view that shares the ownership of its buffer, rows and elements are read through view()
+template<
+    typename _Ty = float,
+    class _ElemTraitsTy = elem_traits<_Ty> >
+    class shared_matrix_view
+    {
+public :
+      using type_t = typename _ElemTraitsTy::type_t;
+      using view_t = matrix_view<_Ty, _ElemTraitsTy>;
+private :
+      std::shared_ptr<type_t[]> array_;
+      view_t                    view_;
+public :
+      shared_matrix_view() = default;
+      // std::default_delete<_Ty[]>()
+      shared_matrix_view( std::shared_ptr<type_t[]> array, size_t size, size_t col_size = 3 )
+        : array_( std::move( array ) )
+        , view_( array_.get(), size, col_size )
+      {
+      }
+
+      view_t const& view() const noexcept {
+        return view_;
+      }
+
+      operator view_t const& () const noexcept {
+        return view_;
+      }
+
+      std::shared_ptr<type_t[]> const& array() const noexcept {
+        return array_;
+      }
+
+      const type_t* data() const noexcept {
+        return view_.data();
+      }
+
+      size_t size() const noexcept {
+        return view_.size();
+      }
+
+      size_t csize() const noexcept {
+        return view_.csize();
+      }
+
+      typename view_t::const_row_t operator [] (size_t const& i) const {
+        return view_[i];
+      }
+    };
+
+static_assert(
+  std::is_trivially_copyable_v< matrix_view<> >,
+  "tvd::matrix_view : the view must stay trivially copyable"
+);
 }
 #endif
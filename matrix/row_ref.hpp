@@ -0,0 +1,311 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the non-owning matrix row reference
+#pragma once
+#ifndef TVD_MATRIX_ROW_REF_HPP
+#define TVD_MATRIX_ROW_REF_HPP
+
+#include "tvd/exception.hpp"
+#include "tvd/expression.hpp"
+#include "tvd/type_traits.hpp"
+
+#include <cstddef>
+
+namespace tvd {
+
+template<
+    typename _Ty,
+    size_t,
+    typename = elem_traits<typename std::remove_pointer<_Ty>::type> >
+    class vector;
+
+inline constexpr size_t dynamic_extent = static_cast<size_t>( -1 );
+// a compile-time extent takes no storage
+template<size_t extent>
+    struct row_extent
+    {
+      constexpr row_extent( size_t = extent ) noexcept
+      {
+      }
+
+      static constexpr size_t size() noexcept {
+        return extent;
+      }
+    };
+
+template<>
+    struct row_extent<dynamic_extent>
+    {
+      size_t size_;
+
+      constexpr row_extent( size_t size ) noexcept
+        : size_( size )
+      {
+      }
+
+      constexpr size_t size() const noexcept {
+        return size_;
+      }
+    };
+
+template<
+    typename _Ty,
+    size_t extent = dynamic_extent>
+    class row_ref;
+
+template<class _Ty>
+    struct is_row_operand : std::false_type { };
+
+template<
+    typename _Ty,
+    size_t size,
+    typename _ElemTraitsTy>
+    struct is_row_operand< vector<_Ty, size, _ElemTraitsTy> > : std::true_type { };
+
+template<
+    typename _Ty,
+    size_t extent>
+    struct is_row_operand< row_ref<_Ty, extent> > : std::true_type { };
+
+template<class _Ty>
+    inline constexpr bool is_row_operand_v = is_row_operand<_Ty>::value;
+
+template<class _Ty>
+    struct is_row_ref : std::false_type { };
+
+template<
+    typename _Ty,
+    size_t extent>
+    struct is_row_ref< row_ref<_Ty, extent> > : std::true_type { };
+// pointer plus extent over one matrix row, copying it rebinds like a span;
+// operator[] is a plain indexed load, at() checks the bounds
+template<
+    typename _Ty,
+    size_t extent>
+    class row_ref : private row_extent<extent>
+    {
+      using extent_t = row_extent<extent>;
+public :
+      using type_t          = std::remove_const_t<_Ty>;
+      using pointer_t       = _Ty*;
+      using reference_t     = _Ty&;
+      using iterator_t      = _Ty*;
+      using vector_t        = vector<type_t, extent>;
+private :
+      _Ty *data_;
+public :
+      constexpr row_ref( _Ty *data, size_t size = extent ) noexcept
+        : extent_t( size )
+        , data_( data )
+      {
+      }
+
+  template<
+      typename Ty,
+      std::enable_if_t<std::is_same_v<const Ty, _Ty> && !std::is_same_v<Ty, _Ty>, bool> = true>
+      constexpr row_ref( row_ref<Ty, extent> const& other ) noexcept
+        : extent_t( other.size() )
+        , data_( other.data() )
+      {
+      }
+
+      using extent_t::size;
+
+      constexpr bool empty() const noexcept {
+        return size() == 0;
+      }
+
+      constexpr pointer_t data() const noexcept {
+        return data_;
+      }
+
+      constexpr iterator_t begin() const noexcept {
+        return data_;
+      }
+
+      constexpr iterator_t end() const noexcept {
+        return data_ + size();
+      }
+
+      constexpr reference_t operator [] ( size_t const& j ) const noexcept {
+        return data_[j];
+      }
+
+      reference_t at( size_t const& j ) const
+      {
+        if( j >= size() ) {
+            throw TVD_EXCEPTION( "<row_ref::at> : bad access" );
+        }
+        return data_[j];
+      }
+      // <other> is a row, a vector or an expression of the same size
+  template<class _OtherTy>
+      row_ref const& assign( _OtherTy const& other ) const
+      {
+        const expression_operand_t<_OtherTy> e( other );
+        check_size( e.extent(), "<row_ref::assign> : <size> != <other.size>" );
+        for( size_t j(0); j < size(); j++ ) {
+            data_[j] = e.eval( j );
+        }
+        return *this;
+      }
+
+  template<
+      size_t extent_ = extent,
+      std::enable_if_t<extent_ != dynamic_extent, bool> = true>
+      operator vector<type_t, extent_> () const
+      {
+        vector<type_t, extent_> vector;
+        for( size_t j(0); j < extent_; j++ ) {
+            vector[j] = data_[j];
+        }
+        return vector;
+      }
+
+  template<class _OtherTy>
+      row_ref const& operator += ( _OtherTy const& other ) const
+      {
+        const expression_operand_t<_OtherTy> e( other );
+        check_size( e.extent(), "<row_ref::operator+=> : <size> != <other.size>" );
+        for( size_t j(0); j < size(); j++ ) {
+            data_[j] += e.eval( j );
+        }
+        return *this;
+      }
+
+  template<class _OtherTy>
+      row_ref const& operator -= ( _OtherTy const& other ) const
+      {
+        const expression_operand_t<_OtherTy> e( other );
+        check_size( e.extent(), "<row_ref::operator-=> : <size> != <other.size>" );
+        for( size_t j(0); j < size(); j++ ) {
+            data_[j] -= e.eval( j );
+        }
+        return *this;
+      }
+
+      row_ref const& operator *= ( type_t const& value ) const
+      {
+        for( size_t j(0); j < size(); j++ ) {
+            data_[j] *= value;
+        }
+        return *this;
+      }
+
+      row_ref const& operator /= ( type_t const& value ) const
+      {
+        if( value <= 0 ) {
+            throw TVD_EXCEPTION( "bad operation : value = 0" );
+        }
+        return *this *= ( 1.0/value );
+      }
+      // comparisons with rows and vectors
+  template<
+      class _OtherTy,
+      std::enable_if_t<is_row_operand_v<_OtherTy>, bool> = true>
+      friend bool operator == ( row_ref const& l, _OtherTy const& r )
+      {
+        if( l.size() != r.size() ) {
+            return false;
+        }
+        for( size_t j(0); j < l.size(); j++ ) {
+            if( l[j] != r[j] ) {
+                return false;
+            }
+        }
+        return true;
+      }
+
+  template<
+      class _OtherTy,
+      std::enable_if_t<is_row_operand_v<_OtherTy>, bool> = true>
+      friend bool operator != ( row_ref const& l, _OtherTy const& r ) {
+        return !( l == r );
+      }
+
+      // lazy arithmetic, see expression.hpp
+  template<
+      class _OtherTy,
+      std::enable_if_t<is_row_operand_v<_OtherTy>, bool> = true>
+      friend auto operator + ( row_ref const& l, _OtherTy const& r ) {
+        lazy_operand();
+        return make_expression<expression_add>( l, r );
+      }
+
+  template<
+      class _OtherTy,
+      std::enable_if_t<is_row_operand_v<_OtherTy>, bool> = true>
+      friend auto operator - ( row_ref const& l, _OtherTy const& r ) {
+        lazy_operand();
+        return make_expression<expression_sub>( l, r );
+      }
+
+  template<
+      class _OtherTy,
+      std::enable_if_t<is_row_operand_v<_OtherTy> && !is_row_ref<_OtherTy>::value, bool> = true>
+      friend auto operator + ( _OtherTy const& l, row_ref const& r ) {
+        lazy_operand();
+        return make_expression<expression_add>( l, r );
+      }
+
+  template<
+      class _OtherTy,
+      std::enable_if_t<is_row_operand_v<_OtherTy> && !is_row_ref<_OtherTy>::value, bool> = true>
+      friend auto operator - ( _OtherTy const& l, row_ref const& r ) {
+        lazy_operand();
+        return make_expression<expression_sub>( l, r );
+      }
+
+      friend auto operator * ( row_ref const& l, type_t const& value ) {
+        lazy_operand();
+        return make_scalar_expression<expression_mul>( l, value );
+      }
+
+      friend auto operator / ( row_ref const& l, type_t const& value )
+      {
+        lazy_operand();
+        if( value <= 0 ) {
+            throw TVD_EXCEPTION( "bad operation : value = 0" );
+        }
+        return make_scalar_expression<expression_mul>( l, type_t( 1.0/value ) );
+      }
+private :
+      // the lazy operators, a row with a runtime extent is no expression operand
+      static constexpr void lazy_operand() noexcept {
+        static_assert(
+          extent != dynamic_extent,
+          "< tvd::row_ref > : rows with a runtime extent are not expression operands"
+        );
+      }
+
+      void check_size( size_t other, const char *message ) const
+      {
+        if( other != size() ) {
+            throw TVD_EXCEPTION( message );
+        }
+      }
+    };
+// rows with a compile-time extent evaluate into vectors
+template<
+    typename _Ty,
+    size_t size>
+    struct expression_traits< row_ref<_Ty, size> >
+    {
+      using result_t = vector<std::remove_const_t<_Ty>, size>;
+      using type_t   = std::remove_const_t<_Ty>;
+      // a row is a pointer, the expression keeps a copy of it rather than of the temporary m[i]
+      static constexpr bool by_value = true;
+
+      static size_t extent( row_ref<_Ty, size> const& r ) {
+        return r.size();
+      }
+
+      static type_t eval( row_ref<_Ty, size> const& r, size_t i ) {
+        return r[i];
+      }
+    };
+// rows with a runtime extent are not expression operands : left undefined, so is_expression_operand_v
+// is false for them and their own == and != are picked
+template<typename _Ty>
+    struct expression_traits< row_ref<_Ty, dynamic_extent> >;
+} // tvd
+#endif
@@ -0,0 +1,354 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the element-wise simd kernels
+#pragma once
+#ifndef TVD_MATRIX_SIMD_HPP
+#define TVD_MATRIX_SIMD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if !defined(TVD_NO_SIMD) && ( defined(__GNUC__) || defined(__clang__) ) && ( defined(__x86_64__) || defined(__i386__) )
+# define TVD_SIMD_X86
+# include <immintrin.h>
+# define TVD_SIMD_TARGET(isa) __attribute__(( target( isa ) ))
+#endif
+// no fused multiply-add contraction, a kernel rounds the same on every instruction set : gcc takes the
+// function attribute, clang the pragma at the top of the function body
+#if defined(__clang__)
+# define TVD_NO_FP_CONTRACT
+# define TVD_NO_FP_CONTRACT_BODY _Pragma( "STDC FP_CONTRACT OFF" )
+#elif defined(__GNUC__)
+# define TVD_NO_FP_CONTRACT __attribute__(( optimize( "fp-contract=off" ) ))
+# define TVD_NO_FP_CONTRACT_BODY
+#else
+# define TVD_NO_FP_CONTRACT
+# define TVD_NO_FP_CONTRACT_BODY
+#endif
+
+namespace tvd {
+    namespace simd {
+      // instruction set levels, every level implies the previous ones
+      enum class isa_t : int { scalar = 0, sse2, avx2, avx512 };
+      // arrays shorter than this are not worth a dispatch
+      constexpr size_t min_size = 16;
+
+      inline isa_t detect() noexcept
+      {
+#ifdef TVD_SIMD_X86
+        __builtin_cpu_init();
+        if( __builtin_cpu_supports( "avx512f" ) && __builtin_cpu_supports( "avx512bw" ) && __builtin_cpu_supports( "avx512dq" ) ) {
+            return isa_t::avx512;
+        }
+        if( __builtin_cpu_supports( "avx2" ) ) {
+            return isa_t::avx2;
+        }
+        if( __builtin_cpu_supports( "sse2" ) ) {
+            return isa_t::sse2;
+        }
+#endif
+        return isa_t::scalar;
+      }
+
+      inline isa_t & active_isa() noexcept
+      {
+        static isa_t isa = detect();
+        return isa;
+      }
+      // current dispatch level
+      inline isa_t isa() noexcept {
+        return active_isa();
+      }
+      // lowers the dispatch level, a level above the detected one is clamped
+      inline void set_isa( isa_t isa ) noexcept {
+        active_isa() = static_cast<int>( isa ) < static_cast<int>( detect() ) ? isa : detect();
+      }
+
+      namespace detail {
+        // kernels operate on integers by width, signedness does not matter for + - and low-half *
+    template<typename _Ty>
+        using lane_t = std::conditional_t<
+          std::is_floating_point_v<_Ty>,
+          _Ty,
+          std::integral_constant<size_t, sizeof(_Ty)>
+        >;
+
+    template<typename _Ty>
+        inline constexpr bool is_kernel_type_v = std::is_arithmetic_v<_Ty> && !std::is_same_v<_Ty, bool> &&
+                                                 ( sizeof(_Ty) == 1 || sizeof(_Ty) == 2 || sizeof(_Ty) == 4 || sizeof(_Ty) == 8 );
+
+        struct add_op {
+      template<typename _Ty>
+          static _Ty apply( _Ty l, _Ty r ) { return l + r; }
+        };
+
+        struct sub_op {
+      template<typename _Ty>
+          static _Ty apply( _Ty l, _Ty r ) { return l - r; }
+        };
+
+        struct mul_op {
+      template<typename _Ty>
+          static _Ty apply( _Ty l, _Ty r ) { return l*r; }
+        };
+
+    template<
+        class _OpTy,
+        typename _Ty>
+        void scalar_binary( _Ty *dst, const _Ty *src, size_t n )
+        {
+          for( size_t i(0); i < n; i++ ) {
+              dst[i] = _OpTy::apply( dst[i], src[i] );
+          }
+        }
+
+    template<
+        class _OpTy,
+        typename _Ty>
+        void scalar_unary( _Ty *dst, _Ty value, size_t n )
+        {
+          for( size_t i(0); i < n; i++ ) {
+              dst[i] = _OpTy::apply( dst[i], value );
+          }
+        }
+#ifdef TVD_SIMD_X86
+        // one namespace per instruction set, everything inside is compiled for that target only
+        namespace sse2 {
+# define TVD_SIMD_FN TVD_SIMD_TARGET( "sse2" ) inline
+          constexpr size_t bytes = 16;
+
+          TVD_SIMD_FN __m128  load( const float  *p ) { return _mm_loadu_ps( p ); }
+          TVD_SIMD_FN __m128d load( const double *p ) { return _mm_loadu_pd( p ); }
+          TVD_SIMD_FN __m128i load( const void   *p ) { return _mm_loadu_si128( static_cast<const __m128i*>( p ) ); }
+          TVD_SIMD_FN void    store( float  *p, __m128  v ) { _mm_storeu_ps( p, v ); }
+          TVD_SIMD_FN void    store( double *p, __m128d v ) { _mm_storeu_pd( p, v ); }
+          TVD_SIMD_FN void    store( void   *p, __m128i v ) { _mm_storeu_si128( static_cast<__m128i*>( p ), v ); }
+
+          TVD_SIMD_FN __m128  set1( float  v ) { return _mm_set1_ps( v ); }
+          TVD_SIMD_FN __m128d set1( double v ) { return _mm_set1_pd( v ); }
+          TVD_SIMD_FN __m128i set1( int16_t v, std::integral_constant<size_t, 2> ) { return _mm_set1_epi16( v ); }
+
+          TVD_SIMD_FN __m128  op( add_op, __m128  l, __m128  r, float  ) { return _mm_add_ps( l, r ); }
+          TVD_SIMD_FN __m128d op( add_op, __m128d l, __m128d r, double ) { return _mm_add_pd( l, r ); }
+          TVD_SIMD_FN __m128i op( add_op, __m128i l, __m128i r, std::integral_constant<size_t, 1> ) { return _mm_add_epi8 ( l, r ); }
+          TVD_SIMD_FN __m128i op( add_op, __m128i l, __m128i r, std::integral_constant<size_t, 2> ) { return _mm_add_epi16( l, r ); }
+          TVD_SIMD_FN __m128i op( add_op, __m128i l, __m128i r, std::integral_constant<size_t, 4> ) { return _mm_add_epi32( l, r ); }
+          TVD_SIMD_FN __m128i op( add_op, __m128i l, __m128i r, std::integral_constant<size_t, 8> ) { return _mm_add_epi64( l, r ); }
+          TVD_SIMD_FN __m128  op( sub_op, __m128  l, __m128  r, float  ) { return _mm_sub_ps( l, r ); }
+          TVD_SIMD_FN __m128d op( sub_op, __m128d l, __m128d r, double ) { return _mm_sub_pd( l, r ); }
+          TVD_SIMD_FN __m128i op( sub_op, __m128i l, __m128i r, std::integral_constant<size_t, 1> ) { return _mm_sub_epi8 ( l, r ); }
+          TVD_SIMD_FN __m128i op( sub_op, __m128i l, __m128i r, std::integral_constant<size_t, 2> ) { return _mm_sub_epi16( l, r ); }
+          TVD_SIMD_FN __m128i op( sub_op, __m128i l, __m128i r, std::integral_constant<size_t, 4> ) { return _mm_sub_epi32( l, r ); }
+          TVD_SIMD_FN __m128i op( sub_op, __m128i l, __m128i r, std::integral_constant<size_t, 8> ) { return _mm_sub_epi64( l, r ); }
+          TVD_SIMD_FN __m128  op( mul_op, __m128  l, __m128  r, float  ) { return _mm_mul_ps( l, r ); }
+          TVD_SIMD_FN __m128d op( mul_op, __m128d l, __m128d r, double ) { return _mm_mul_pd( l, r ); }
+          TVD_SIMD_FN __m128i op( mul_op, __m128i l, __m128i r, std::integral_constant<size_t, 2> ) { return _mm_mullo_epi16( l, r ); }
+          // integer products sse2 can not do in one instruction fall back to the scalar loop
+      template<class _OpTy, typename _Ty>
+          inline constexpr bool has_op_v = std::is_floating_point_v<_Ty> || !std::is_same_v<_OpTy, mul_op> || sizeof(_Ty) == 2;
+
+      template<typename _Ty>
+          TVD_SIMD_FN auto splat( _Ty v )
+          {
+            if constexpr( std::is_floating_point_v<_Ty> ) {
+                return set1( v );
+            } else {
+                return set1( static_cast<std::make_signed_t<_Ty> >( v ), lane_t<_Ty>() );
+            }
+          }
+# undef TVD_SIMD_FN
+        } // sse2
+
+        namespace avx2 {
+# define TVD_SIMD_FN TVD_SIMD_TARGET( "avx2" ) inline
+          constexpr size_t bytes = 32;
+
+          TVD_SIMD_FN __m256  load( const float  *p ) { return _mm256_loadu_ps( p ); }
+          TVD_SIMD_FN __m256d load( const double *p ) { return _mm256_loadu_pd( p ); }
+          TVD_SIMD_FN __m256i load( const void   *p ) { return _mm256_loadu_si256( static_cast<const __m256i*>( p ) ); }
+          TVD_SIMD_FN void    store( float  *p, __m256  v ) { _mm256_storeu_ps( p, v ); }
+          TVD_SIMD_FN void    store( double *p, __m256d v ) { _mm256_storeu_pd( p, v ); }
+          TVD_SIMD_FN void    store( void   *p, __m256i v ) { _mm256_storeu_si256( static_cast<__m256i*>( p ), v ); }
+
+          TVD_SIMD_FN __m256  set1( float  v ) { return _mm256_set1_ps( v ); }
+          TVD_SIMD_FN __m256d set1( double v ) { return _mm256_set1_pd( v ); }
+          TVD_SIMD_FN __m256i set1( int16_t v, std::integral_constant<size_t, 2> ) { return _mm256_set1_epi16( v ); }
+          TVD_SIMD_FN __m256i set1( int32_t v, std::integral_constant<size_t, 4> ) { return _mm256_set1_epi32( v ); }
+
+          TVD_SIMD_FN __m256  op( add_op, __m256  l, __m256  r, float  ) { return _mm256_add_ps( l, r ); }
+          TVD_SIMD_FN __m256d op( add_op, __m256d l, __m256d r, double ) { return _mm256_add_pd( l, r ); }
+          TVD_SIMD_FN __m256i op( add_op, __m256i l, __m256i r, std::integral_constant<size_t, 1> ) { return _mm256_add_epi8 ( l, r ); }
+          TVD_SIMD_FN __m256i op( add_op, __m256i l, __m256i r, std::integral_constant<size_t, 2> ) { return _mm256_add_epi16( l, r ); }
+          TVD_SIMD_FN __m256i op( add_op, __m256i l, __m256i r, std::integral_constant<size_t, 4> ) { return _mm256_add_epi32( l, r ); }
+          TVD_SIMD_FN __m256i op( add_op, __m256i l, __m256i r, std::integral_constant<size_t, 8> ) { return _mm256_add_epi64( l, r ); }
+          TVD_SIMD_FN __m256  op( sub_op, __m256  l, __m256  r, float  ) { return _mm256_sub_ps( l, r ); }
+          TVD_SIMD_FN __m256d op( sub_op, __m256d l, __m256d r, double ) { return _mm256_sub_pd( l, r ); }
+          TVD_SIMD_FN __m256i op( sub_op, __m256i l, __m256i r, std::integral_constant<size_t, 1> ) { return _mm256_sub_epi8 ( l, r ); }
+          TVD_SIMD_FN __m256i op( sub_op, __m256i l, __m256i r, std::integral_constant<size_t, 2> ) { return _mm256_sub_epi16( l, r ); }
+          TVD_SIMD_FN __m256i op( sub_op, __m256i l, __m256i r, std::integral_constant<size_t, 4> ) { return _mm256_sub_epi32( l, r ); }
+          TVD_SIMD_FN __m256i op( sub_op, __m256i l, __m256i r, std::integral_constant<size_t, 8> ) { return _mm256_sub_epi64( l, r ); }
+          TVD_SIMD_FN __m256  op( mul_op, __m256  l, __m256  r, float  ) { return _mm256_mul_ps( l, r ); }
+          TVD_SIMD_FN __m256d op( mul_op, __m256d l, __m256d r, double ) { return _mm256_mul_pd( l, r ); }
+          TVD_SIMD_FN __m256i op( mul_op, __m256i l, __m256i r, std::integral_constant<size_t, 2> ) { return _mm256_mullo_epi16( l, r ); }
+          TVD_SIMD_FN __m256i op( mul_op, __m256i l, __m256i r, std::integral_constant<size_t, 4> ) { return _mm256_mullo_epi32( l, r ); }
+
+      template<class _OpTy, typename _Ty>
+          inline constexpr bool has_op_v = std::is_floating_point_v<_Ty> || !std::is_same_v<_OpTy, mul_op> || sizeof(_Ty) == 2 || sizeof(_Ty) == 4;
+
+      template<typename _Ty>
+          TVD_SIMD_FN auto splat( _Ty v )
+          {
+            if constexpr( std::is_floating_point_v<_Ty> ) {
+                return set1( v );
+            } else {
+                return set1( static_cast<std::make_signed_t<_Ty> >( v ), lane_t<_Ty>() );
+            }
+          }
+# undef TVD_SIMD_FN
+        } // avx2
+
+        namespace avx512 {
+# define TVD_SIMD_FN TVD_SIMD_TARGET( "avx512f,avx512bw,avx512dq" ) inline
+          constexpr size_t bytes = 64;
+
+          TVD_SIMD_FN __m512  load( const float  *p ) { return _mm512_loadu_ps( p ); }
+          TVD_SIMD_FN __m512d load( const double *p ) { return _mm512_loadu_pd( p ); }
+          TVD_SIMD_FN __m512i load( const void   *p ) { return _mm512_loadu_si512( p ); }
+          TVD_SIMD_FN void    store( float  *p, __m512  v ) { _mm512_storeu_ps( p, v ); }
+          TVD_SIMD_FN void    store( double *p, __m512d v ) { _mm512_storeu_pd( p, v ); }
+          TVD_SIMD_FN void    store( void   *p, __m512i v ) { _mm512_storeu_si512( p, v ); }
+
+          TVD_SIMD_FN __m512  set1( float  v ) { return _mm512_set1_ps( v ); }
+          TVD_SIMD_FN __m512d set1( double v ) { return _mm512_set1_pd( v ); }
+          TVD_SIMD_FN __m512i set1( int16_t v, std::integral_constant<size_t, 2> ) { return _mm512_set1_epi16( v ); }
+          TVD_SIMD_FN __m512i set1( int32_t v, std::integral_constant<size_t, 4> ) { return _mm512_set1_epi32( v ); }
+          TVD_SIMD_FN __m512i set1( int64_t v, std::integral_constant<size_t, 8> ) { return _mm512_set1_epi64( v ); }
+
+          TVD_SIMD_FN __m512  op( add_op, __m512  l, __m512  r, float  ) { return _mm512_add_ps( l, r ); }
+          TVD_SIMD_FN __m512d op( add_op, __m512d l, __m512d r, double ) { return _mm512_add_pd( l, r ); }
+          TVD_SIMD_FN __m512i op( add_op, __m512i l, __m512i r, std::integral_constant<size_t, 1> ) { return _mm512_add_epi8 ( l, r ); }
+          TVD_SIMD_FN __m512i op( add_op, __m512i l, __m512i r, std::integral_constant<size_t, 2> ) { return _mm512_add_epi16( l, r ); }
+          TVD_SIMD_FN __m512i op( add_op, __m512i l, __m512i r, std::integral_constant<size_t, 4> ) { return _mm512_add_epi32( l, r ); }
+          TVD_SIMD_FN __m512i op( add_op, __m512i l, __m512i r, std::integral_constant<size_t, 8> ) { return _mm512_add_epi64( l, r ); }
+          TVD_SIMD_FN __m512  op( sub_op, __m512  l, __m512  r, float  ) { return _mm512_sub_ps( l, r ); }
+          TVD_SIMD_FN __m512d op( sub_op, __m512d l, __m512d r, double ) { return _mm512_sub_pd( l, r ); }
+          TVD_SIMD_FN __m512i op( sub_op, __m512i l, __m512i r, std::integral_constant<size_t, 1> ) { return _mm512_sub_epi8 ( l, r ); }
+          TVD_SIMD_FN __m512i op( sub_op, __m512i l, __m512i r, std::integral_constant<size_t, 2> ) { return _mm512_sub_epi16( l, r ); }
+          TVD_SIMD_FN __m512i op( sub_op, __m512i l, __m512i r, std::integral_constant<size_t, 4> ) { return _mm512_sub_epi32( l, r ); }
+          TVD_SIMD_FN __m512i op( sub_op, __m512i l, __m512i r, std::integral_constant<size_t, 8> ) { return _mm512_sub_epi64( l, r ); }
+          TVD_SIMD_FN __m512  op( mul_op, __m512  l, __m512  r, float  ) { return _mm512_mul_ps( l, r ); }
+          TVD_SIMD_FN __m512d op( mul_op, __m512d l, __m512d r, double ) { return _mm512_mul_pd( l, r ); }
+          TVD_SIMD_FN __m512i op( mul_op, __m512i l, __m512i r, std::integral_constant<size_t, 2> ) { return _mm512_mullo_epi16( l, r ); }
+          TVD_SIMD_FN __m512i op( mul_op, __m512i l, __m512i r, std::integral_constant<size_t, 4> ) { return _mm512_mullo_epi32( l, r ); }
+          TVD_SIMD_FN __m512i op( mul_op, __m512i l, __m512i r, std::integral_constant<size_t, 8> ) { return _mm512_mullo_epi64( l, r ); }
+
+      template<class _OpTy, typename _Ty>
+          inline constexpr bool has_op_v = std::is_floating_point_v<_Ty> || !std::is_same_v<_OpTy, mul_op> || sizeof(_Ty) != 1;
+
+      template<typename _Ty>
+          TVD_SIMD_FN auto splat( _Ty v )
+          {
+            if constexpr( std::is_floating_point_v<_Ty> ) {
+                return set1( v );
+            } else {
+                return set1( static_cast<std::make_signed_t<_Ty> >( v ), lane_t<_Ty>() );
+            }
+          }
+# undef TVD_SIMD_FN
+        } // avx512
+        // the same loop bodies instantiated once per instruction set
+# define TVD_SIMD_KERNELS( isa, target )                                                        \
+    template<class _OpTy, typename _Ty>                                                          \
+        TVD_SIMD_TARGET( target ) void isa##_binary( _Ty *dst, const _Ty *src, size_t n )        \
+        {                                                                                        \
+          constexpr size_t step = isa::bytes/sizeof(_Ty);                                        \
+          size_t i(0);                                                                           \
+          if constexpr( isa::has_op_v<_OpTy, _Ty> ) {                                            \
+              for( ; i + step <= n; i += step ) {                                                \
+                  isa::store( dst + i, isa::op( _OpTy(), isa::load( dst + i ),                   \
+                                                isa::load( src + i ), lane_t<_Ty>() ) );         \
+              }                                                                                  \
+          }                                                                                      \
+          for( ; i < n; i++ ) {                                                                  \
+              dst[i] = _OpTy::apply( dst[i], src[i] );                                           \
+          }                                                                                      \
+        }                                                                                        \
+                                                                                                 \
+    template<class _OpTy, typename _Ty>                                                          \
+        TVD_SIMD_TARGET( target ) void isa##_unary( _Ty *dst, _Ty value, size_t n )              \
+        {                                                                                        \
+          constexpr size_t step = isa::bytes/sizeof(_Ty);                                        \
+          size_t i(0);                                                                           \
+          if constexpr( isa::has_op_v<_OpTy, _Ty> ) {                                            \
+              const auto v = isa::splat( value );                                                \
+              for( ; i + step <= n; i += step ) {                                                \
+                  isa::store( dst + i, isa::op( _OpTy(), isa::load( dst + i ), v, lane_t<_Ty>() ) ); \
+              }                                                                                  \
+          }                                                                                      \
+          for( ; i < n; i++ ) {                                                                  \
+              dst[i] = _OpTy::apply( dst[i], value );                                            \
+          }                                                                                      \
+        }
+
+        TVD_SIMD_KERNELS( sse2,   "sse2" )
+        TVD_SIMD_KERNELS( avx2,   "avx2" )
+        TVD_SIMD_KERNELS( avx512, "avx512f,avx512bw,avx512dq" )
+# undef TVD_SIMD_KERNELS
+#endif
+        // dst[i] = op( dst[i], src[i] )
+    template<
+        class _OpTy,
+        typename _Ty>
+        void binary( _Ty *dst, const _Ty *src, size_t n )
+        {
+          if constexpr( is_kernel_type_v<_Ty> ) {
+#ifdef TVD_SIMD_X86
+              switch( simd::isa() )
+              {
+                case isa_t::avx512 : return avx512_binary<_OpTy>( dst, src, n );
+                case isa_t::avx2   : return avx2_binary<_OpTy>( dst, src, n );
+                case isa_t::sse2   : return sse2_binary<_OpTy>( dst, src, n );
+                default            : break;
+              }
+#endif
+          }
+          scalar_binary<_OpTy>( dst, src, n );
+        }
+        // dst[i] = op( dst[i], value )
+    template<
+        class _OpTy,
+        typename _Ty>
+        void unary( _Ty *dst, _Ty value, size_t n )
+        {
+          if constexpr( is_kernel_type_v<_Ty> ) {
+#ifdef TVD_SIMD_X86
+              switch( simd::isa() )
+              {
+                case isa_t::avx512 : return avx512_unary<_OpTy>( dst, value, n );
+                case isa_t::avx2   : return avx2_unary<_OpTy>( dst, value, n );
+                case isa_t::sse2   : return sse2_unary<_OpTy>( dst, value, n );
+                default            : break;
+              }
+#endif
+          }
+          scalar_unary<_OpTy>( dst, value, n );
+        }
+      } // detail
+      // dst[i] += src[i]
+  template<typename _Ty>
+      void add( _Ty *dst, const _Ty *src, size_t n ) {
+        detail::binary<detail::add_op>( dst, src, n );
+      }
+      // dst[i] -= src[i]
+  template<typename _Ty>
+      void sub( _Ty *dst, const _Ty *src, size_t n ) {
+        detail::binary<detail::sub_op>( dst, src, n );
+      }
+      // dst[i] *= value
+  template<typename _Ty>
+      void scale( _Ty *dst, _Ty value, size_t n ) {
+        detail::unary<detail::mul_op>( dst, value, n );
+      }
+    } // simd
+} // tvd
+#endif
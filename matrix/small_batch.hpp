@@ -0,0 +1,269 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the batched small matrices
+#pragma once
+#ifndef TVD_MATRIX_SMALL_BATCH_HPP
+#define TVD_MATRIX_SMALL_BATCH_HPP
+
+#include "tvd/allocator.hpp"
+#include "tvd/thread_pool.hpp"
+#include "tvd/matrix/simd.hpp"
+#include "tvd/matrix/small_matrix.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace tvd {
+// <count> <dim> x <dim> matrices interleaved by blocks of <lanes> : the element (i, j) of the matrix <m> is
+// data()[( m/lanes )*block + ( i*dim + j )*lanes + m%lanes], so one vector load takes the same element
+// of <lanes> matrices. the tail of the last block is zero
+template<
+    typename _Ty,
+    size_t dim>
+    class small_matrix_batch
+    {
+      static_assert( dim >= 1 && dim <= 4, "< tvd::small_matrix_batch > : closed forms up to 4x4" );
+public :
+      // one cache line of every element, an avx-512 register
+      static constexpr size_t lanes = 64/sizeof(_Ty);
+      static constexpr size_t block = dim*dim*lanes;
+private :
+      std::vector<_Ty, aligned_allocator<_Ty> > data_;
+      size_t                                     count_;
+public :
+      small_matrix_batch()
+        : count_( 0 )
+      {
+      }
+
+      explicit small_matrix_batch( size_t count )
+        : data_( ( count + lanes - 1 )/lanes*block, _Ty(0) )
+        , count_( count )
+      {
+      }
+
+      size_t size() const noexcept {
+        return count_;
+      }
+
+      size_t blocks() const noexcept {
+        return data_.size()/block;
+      }
+
+      _Ty* data() noexcept {
+        return data_.data();
+      }
+
+      const _Ty* data() const noexcept {
+        return data_.data();
+      }
+      // unchecked element (i, j) of the matrix <m>
+      _Ty & operator () ( size_t m, size_t i, size_t j ) noexcept {
+        return data_[( m/lanes )*block + ( i*dim + j )*lanes + m%lanes];
+      }
+
+      _Ty operator () ( size_t m, size_t i, size_t j ) const noexcept {
+        return data_[( m/lanes )*block + ( i*dim + j )*lanes + m%lanes];
+      }
+
+      small_matrix<_Ty, dim, dim> get( size_t m ) const
+      {
+        if( m >= count_ ) {
+            throw TVD_EXCEPTION( "<small_matrix_batch::get> : out of range" );
+        }
+        small_matrix<_Ty, dim, dim> a;
+        for( size_t i(0); i < dim; i++ ) {
+            for( size_t j(0); j < dim; j++ ) {
+                a( i, j ) = ( *this )( m, i, j );
+            }
+        }
+        return a;
+      }
+
+      void set( size_t m, small_matrix<_Ty, dim, dim> const& a )
+      {
+        if( m >= count_ ) {
+            throw TVD_EXCEPTION( "<small_matrix_batch::set> : out of range" );
+        }
+        for( size_t i(0); i < dim; i++ ) {
+            for( size_t j(0); j < dim; j++ ) {
+                ( *this )( m, i, j ) = a( i, j );
+            }
+        }
+      }
+    };
+
+    namespace detail {
+      // the same element of <lanes> interleaved matrices; every operation is a loop of a fixed trip count
+      // over independent lanes, which the compiler turns into whole-register instructions
+  template<
+      typename _Ty,
+      size_t lanes>
+      struct small_lanes
+      {
+        _Ty v[lanes];
+
+        friend small_lanes operator + ( small_lanes const& l, small_lanes const& r ) noexcept
+        {
+          small_lanes o;
+          for( size_t i(0); i < lanes; i++ ) {
+              o.v[i] = l.v[i] + r.v[i];
+          }
+          return o;
+        }
+
+        friend small_lanes operator - ( small_lanes const& l, small_lanes const& r ) noexcept
+        {
+          small_lanes o;
+          for( size_t i(0); i < lanes; i++ ) {
+              o.v[i] = l.v[i] - r.v[i];
+          }
+          return o;
+        }
+
+        friend small_lanes operator * ( small_lanes const& l, small_lanes const& r ) noexcept
+        {
+          small_lanes o;
+          for( size_t i(0); i < lanes; i++ ) {
+              o.v[i] = l.v[i]*r.v[i];
+          }
+          return o;
+        }
+
+        friend small_lanes operator - ( small_lanes const& r ) noexcept
+        {
+          small_lanes o;
+          for( size_t i(0); i < lanes; i++ ) {
+              o.v[i] = -r.v[i];
+          }
+          return o;
+        }
+      };
+      // 1/det per lane without a branch : a zero lane divides 0 by 1
+  template<
+      typename _Ty,
+      size_t lanes>
+      small_lanes<_Ty, lanes> small_reciprocal( small_lanes<_Ty, lanes> const& det ) noexcept
+      {
+        small_lanes<_Ty, lanes> o;
+        for( size_t i(0); i < lanes; i++ ) {
+            o.v[i] = _Ty( det.v[i] != _Ty(0) )/( det.v[i] + _Ty( det.v[i] == _Ty(0) ) );
+        }
+        return o;
+      }
+      // one element of an interleaved block as an assignable pack
+  template<
+      typename _Ty,
+      size_t lanes>
+      struct small_lanes_ref
+      {
+        _Ty *p;
+
+        void operator = ( small_lanes<_Ty, lanes> const& x ) const noexcept {
+          std::copy_n( x.v, lanes, p );
+        }
+      };
+      // blocks [first, last) : the determinants and, when <b> is given, the inverses, a block at a time
+  template<
+      typename _Ty,
+      size_t dim>
+      TVD_NO_FP_CONTRACT inline void small_batch_blocks( const _Ty *a, _Ty *b, _Ty *det, size_t first, size_t last )
+      {
+        constexpr size_t lanes = small_matrix_batch<_Ty, dim>::lanes;
+        constexpr size_t block = small_matrix_batch<_Ty, dim>::block;
+        using lanes_t = small_lanes<_Ty, lanes>;
+        for( size_t k(first); k < last; k++ )
+        {
+            const _Ty *ak = a + k*block;
+            auto in = [ak]( size_t i, size_t j )
+            {
+              lanes_t x;
+              std::copy_n( ak + ( i*dim + j )*lanes, lanes, x.v );
+              return x;
+            };
+            lanes_t d;
+            if( b ) {
+                _Ty *bk = b + k*block;
+                d = small_inverse<lanes_t, dim>( in, [bk]( size_t i, size_t j ) {
+                  return small_lanes_ref<_Ty, lanes>{ bk + ( i*dim + j )*lanes };
+                } );
+            } else {
+                d = small_determinant<lanes_t, dim>( in );
+            }
+            std::copy_n( d.v, lanes, det + k*lanes );
+        }
+      }
+#ifdef TVD_SIMD_X86
+  template<
+      typename _Ty,
+      size_t dim>
+      TVD_SIMD_TARGET( "avx2" ) TVD_NO_FP_CONTRACT __attribute__(( flatten )) void small_batch_blocks_avx2( const _Ty *a, _Ty *b, _Ty *det, size_t first, size_t last ) {
+        small_batch_blocks<_Ty, dim>( a, b, det, first, last );
+      }
+
+  template<
+      typename _Ty,
+      size_t dim>
+      TVD_SIMD_TARGET( "avx512f,avx512bw,avx512dq" ) TVD_NO_FP_CONTRACT __attribute__(( flatten )) void small_batch_blocks_avx512( const _Ty *a, _Ty *b, _Ty *det, size_t first, size_t last ) {
+        small_batch_blocks<_Ty, dim>( a, b, det, first, last );
+      }
+#endif
+      // the blocks are split over the thread pool, every chunk runs the kernel of the active instruction set
+  template<
+      typename _Ty,
+      size_t dim>
+      void small_batch_run( small_matrix_batch<_Ty, dim> const& a, _Ty *b, _Ty *det )
+      {
+        constexpr size_t grain = 1024;
+        tvd::parallel_for( 0, a.blocks(), grain, [&]( size_t first, size_t last )
+        {
+#ifdef TVD_SIMD_X86
+          switch( simd::isa() )
+          {
+            case simd::isa_t::avx512 : return small_batch_blocks_avx512<_Ty, dim>( a.data(), b, det, first, last );
+            case simd::isa_t::avx2   : return small_batch_blocks_avx2<_Ty, dim>( a.data(), b, det, first, last );
+            default                  : break;
+          }
+#endif
+          small_batch_blocks<_Ty, dim>( a.data(), b, det, first, last );
+        } );
+      }
+    } // detail
+// det[m] is the determinant of the matrix <m> of <a>
+template<
+    typename _Ty,
+    size_t dim>
+    void determinant( small_matrix_batch<_Ty, dim> const& a, std::vector<_Ty> & det )
+    {
+      det.resize( a.blocks()*a.lanes );
+      detail::small_batch_run( a, static_cast<_Ty*>( nullptr ), det.data() );
+      det.resize( a.size() );
+    }
+// <b> gets the inverse of every matrix of <a> and singular[m] is 1 for a zero determinant, the inverse
+// of such a matrix is left zero; returns the number of singular matrices
+template<
+    typename _Ty,
+    size_t dim>
+    size_t inverse( small_matrix_batch<_Ty, dim> const& a, small_matrix_batch<_Ty, dim> & b, std::vector<uint8_t> & singular )
+    {
+      static_assert( std::is_floating_point_v<_Ty>, "< tvd::inverse > : <_Ty> must be floating point" );
+      if( &b == &a ) {
+          throw TVD_EXCEPTION( "<tvd::inverse> : <b> is <a>" );
+      }
+      if( b.size() != a.size() ) {
+          b = small_matrix_batch<_Ty, dim>( a.size() );
+      }
+      // determinants of the call, the thread's grow-only buffer unless a caller up the stack holds it
+      local_lease<std::vector<_Ty> > det;
+      det->resize( a.blocks()*a.lanes );
+      detail::small_batch_run( a, b.data(), det->data() );
+      singular.resize( a.size() );
+      size_t count = 0;
+      for( size_t m(0); m < a.size(); m++ ) {
+          singular[m] = (*det)[m] == _Ty(0);
+          count += singular[m];
+      }
+      return count;
+    }
+} // tvd
+#endif
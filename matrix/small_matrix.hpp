@@ -0,0 +1,431 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the fixed-shape small matrix
+#pragma once
+#ifndef TVD_MATRIX_SMALL_MATRIX_HPP
+#define TVD_MATRIX_SMALL_MATRIX_HPP
+
+#include "tvd/base_mixing_templates.hpp"
+#include "tvd/type_traits.hpp"
+#include "tvd/matrix/matrix.hpp"
+#include "tvd/matrix/row_ref.hpp"
+#include "tvd/matrix/simd.hpp"
+
+#include <array>
+#include <utility>
+
+namespace tvd {
+
+template<
+    typename _Ty,
+    size_t rows,
+    size_t cols>
+    class small_matrix;
+// small matrix mixing
+template<
+    typename _Ty,
+    size_t rows,
+    size_t cols>
+    using small_mixing_list_t = mixing_list
+    <
+      add_iterators< small_matrix<_Ty, rows, cols>, elem_container<elem_traits<_Ty>, std::array<_Ty, rows*cols> > >,
+      add_non_equalable< small_matrix<_Ty, rows, cols> >
+    >;
+
+    namespace detail {
+      // sum of x[k]*t(k, j) over k, the fold is expanded at compile time
+  template<
+      typename _Ty,
+      size_t rows,
+      size_t cols,
+      size_t ... k>
+      constexpr _Ty small_dot( const _Ty *x, small_matrix<_Ty, rows, cols> const& t, size_t j, std::index_sequence<k...> ) {
+        return ( ( x[k]*t( k, j ) ) + ... );
+      }
+      // y = x*t for one row, <y> may be <x>
+  template<
+      typename _Ty,
+      size_t rows,
+      size_t cols,
+      size_t ... j>
+      constexpr void small_row_product( const _Ty *x, small_matrix<_Ty, rows, cols> const& t, _Ty *y, std::index_sequence<j...> )
+      {
+        const std::array<_Ty, rows> x_ { x[j]... };
+        ( ( y[j] = small_dot( x_.data(), t, j, std::make_index_sequence<rows>() ) ), ... );
+      }
+  template<
+      typename _Ty,
+      size_t rows,
+      size_t cols>
+      constexpr void small_row_product( const _Ty *x, small_matrix<_Ty, rows, cols> const& t, _Ty *y )
+      {
+        static_assert( rows == cols, "< tvd::detail::small_row_product > : <t> must be square" );
+        small_row_product( x, t, y, std::make_index_sequence<cols>() );
+      }
+    } // detail
+// rows x cols matrix in a std::array, row-major; every operation is constexpr and unrolled
+template<
+    typename _Ty,
+    size_t rows,
+    size_t cols>
+    class small_matrix final : public small_mixing_list_t<_Ty, rows, cols>
+    {
+      static_assert(
+        !is_null_size_v<rows> && !is_null_size_v<cols>,
+        "< tvd::small_matrix<_Ty, size_t, size_t> > : <rows> == <0> | <cols> == <0>"
+      );
+
+      static_assert(
+        std::is_arithmetic_v<_Ty>,
+        "< tvd::small_matrix<_Ty, size_t, size_t> > : <_Ty> must be arithmetic"
+      );
+
+      using elem_container_t = elem_container< elem_traits<_Ty>, std::array<_Ty, rows*cols> >;
+      friend struct access<elem_container_t>;
+public :
+      using type_t           = _Ty;
+      using pointer_t        = _Ty*;
+      using const_pointer_t  = const _Ty*;
+      using reference_t      = _Ty&;
+      using row_t            = row_ref<_Ty, cols>;
+      using const_row_t      = row_ref<const _Ty, cols>;
+      using vector_t         = vector<_Ty, cols>;
+      using init_list_t      = std::initializer_list<_Ty> const&;
+private :
+      typename elem_container_t::container_t container_;
+public :
+      constexpr small_matrix() noexcept
+        : container_{}
+      {
+      }
+      // row-major, missing elements are zero
+      constexpr small_matrix( init_list_t list )
+        : container_{}
+      {
+        if( list.size() > rows*cols ) {
+            throw TVD_EXCEPTION( "<small_matrix::small_matrix> : bad <initializer_list> <size>" );
+        }
+        size_t i( 0 );
+        for( auto const& value : list ) {
+            container_[i++] = value;
+        }
+      }
+
+  template<
+      typename _ElemTraitsTy,
+      typename _AllocTy>
+      explicit small_matrix( matrix<_Ty, cols, _ElemTraitsTy, _AllocTy> const& m )
+        : container_{}
+      {
+        if( m.size() != rows ) {
+            throw TVD_EXCEPTION( "<small_matrix::small_matrix> : <matrix.size> != <rows>" );
+        }
+        std::copy( m.begin(), m.end(), container_.begin() );
+      }
+
+      static constexpr small_matrix identity() noexcept
+      {
+        static_assert( rows == cols, "< tvd::small_matrix::identity > : matrix must be square" );
+        small_matrix m;
+        for( size_t i(0); i < rows; i++ ) {
+            m.container_[i*cols + i] = _Ty(1);
+        }
+        return m;
+      }
+
+      static constexpr size_t size() noexcept {
+        return rows;
+      }
+
+      static constexpr size_t csize() noexcept {
+        return cols;
+      }
+
+      constexpr pointer_t data() noexcept {
+        return container_.data();
+      }
+
+      constexpr const_pointer_t data() const noexcept {
+        return container_.data();
+      }
+      // unchecked element access
+      constexpr reference_t operator () ( size_t const& i, size_t const& j ) noexcept {
+        return container_[i*cols + j];
+      }
+
+      constexpr type_t operator () ( size_t const& i, size_t const& j ) const noexcept {
+        return container_[i*cols + j];
+      }
+
+      constexpr row_t operator [] ( size_t const& i )
+      {
+        if( i >= rows ) {
+            throw TVD_EXCEPTION( "<small_matrix::operator[]> : <i> >= <rows>" );
+        }
+        return row_t( container_.data() + i*cols );
+      }
+
+      constexpr const_row_t operator [] ( size_t const& i ) const
+      {
+        if( i >= rows ) {
+            throw TVD_EXCEPTION( "<small_matrix::operator[] const> : <i> >= <rows>" );
+        }
+        return const_row_t( container_.data() + i*cols );
+      }
+
+  template<typename _AllocTy>
+      operator matrix<_Ty, cols, elem_traits<_Ty>, _AllocTy> () const
+      {
+        matrix<_Ty, cols, elem_traits<_Ty>, _AllocTy> m( rows );
+        std::copy( container_.begin(), container_.end(), m.begin() );
+        return m;
+      }
+
+      constexpr small_matrix<_Ty, cols, rows> transpose() const noexcept
+      {
+        small_matrix<_Ty, cols, rows> t;
+        for( size_t i(0); i < rows; i++ ) {
+            for( size_t j(0); j < cols; j++ ) {
+                t( j, i ) = container_[i*cols + j];
+            }
+        }
+        return t;
+      }
+      // overloads
+      constexpr bool operator == ( small_matrix const& other ) const noexcept
+      {
+        for( size_t i(0); i < rows*cols; i++ ) {
+            if( container_[i] != other.container_[i] ) {
+                return false;
+            }
+        }
+        return true;
+      }
+
+      constexpr small_matrix & operator += ( small_matrix const& other ) noexcept
+      {
+        for( size_t i(0); i < rows*cols; i++ ) {
+            container_[i] += other.container_[i];
+        }
+        return *this;
+      }
+
+      constexpr small_matrix & operator -= ( small_matrix const& other ) noexcept
+      {
+        for( size_t i(0); i < rows*cols; i++ ) {
+            container_[i] -= other.container_[i];
+        }
+        return *this;
+      }
+
+      constexpr small_matrix & operator *= ( _Ty const& value ) noexcept
+      {
+        for( auto & it : container_ ) {
+            it *= value;
+        }
+        return *this;
+      }
+      // *this = (*this)*other, row by row
+      constexpr small_matrix & operator *= ( small_matrix<_Ty, cols, cols> const& other ) noexcept
+      {
+        for( size_t i(0); i < rows; i++ ) {
+            detail::small_row_product( container_.data() + i*cols, other, container_.data() + i*cols );
+        }
+        return *this;
+      }
+
+      friend constexpr small_matrix operator + ( small_matrix l, small_matrix const& r ) noexcept {
+        return l += r;
+      }
+
+      friend constexpr small_matrix operator - ( small_matrix l, small_matrix const& r ) noexcept {
+        return l -= r;
+      }
+
+      friend constexpr small_matrix operator * ( small_matrix l, _Ty const& value ) noexcept {
+        return l *= value;
+      }
+
+  template<size_t cols_>
+      friend constexpr small_matrix<_Ty, rows, cols_> operator * ( small_matrix const& l, small_matrix<_Ty, cols, cols_> const& r ) noexcept {
+        return multiply( l, r, std::make_index_sequence<rows*cols_>() );
+      }
+private :
+
+  template<
+      size_t cols_,
+      size_t ... e>
+      static constexpr small_matrix<_Ty, rows, cols_> multiply( small_matrix const& l, small_matrix<_Ty, cols, cols_> const& r,
+                                                               std::index_sequence<e...> ) noexcept
+      {
+        small_matrix<_Ty, rows, cols_> m;
+        ( ( m( e/cols_, e%cols_ ) = detail::small_dot( l.data() + ( e/cols_ )*cols, r, e%cols_, std::make_index_sequence<cols>() ) ), ... );
+        return m;
+      }
+    };
+    namespace detail {
+      // 1/det, zero for a singular matrix
+  template<typename _Ty>
+      constexpr _Ty small_reciprocal( _Ty det ) noexcept {
+        return det != _Ty(0) ? _Ty(1)/det : _Ty(0);
+      }
+      // closed forms up to 4x4 over any element access a(i, j), shared by small_matrix and the batched kernels;
+      // <_Ty> is the element type or a pack of lanes with the arithmetic operators and small_reciprocal().
+      // Never contracted into fused multiply-adds : an exactly singular matrix gives exactly zero on every isa
+  template<
+      typename _Ty,
+      size_t size,
+      class _InTy>
+      TVD_NO_FP_CONTRACT constexpr _Ty small_determinant( _InTy const& a ) noexcept
+      {
+        TVD_NO_FP_CONTRACT_BODY
+        static_assert( size <= 4, "< tvd::determinant > : closed form up to 4x4" );
+        if constexpr( size == 1 ) {
+            return a(0, 0);
+        } else if constexpr( size == 2 ) {
+            return a(0, 0)*a(1, 1) - a(0, 1)*a(1, 0);
+        } else if constexpr( size == 3 ) {
+            return a(0, 0)*( a(1, 1)*a(2, 2) - a(1, 2)*a(2, 1) ) -
+                   a(0, 1)*( a(1, 0)*a(2, 2) - a(1, 2)*a(2, 0) ) +
+                   a(0, 2)*( a(1, 0)*a(2, 1) - a(1, 1)*a(2, 0) );
+        } else {
+            // 2x2 minors of the upper and the lower row pairs
+            const _Ty s0 = a(0, 0)*a(1, 1) - a(1, 0)*a(0, 1);
+            const _Ty s1 = a(0, 0)*a(1, 2) - a(1, 0)*a(0, 2);
+            const _Ty s2 = a(0, 0)*a(1, 3) - a(1, 0)*a(0, 3);
+            const _Ty s3 = a(0, 1)*a(1, 2) - a(1, 1)*a(0, 2);
+            const _Ty s4 = a(0, 1)*a(1, 3) - a(1, 1)*a(0, 3);
+            const _Ty s5 = a(0, 2)*a(1, 3) - a(1, 2)*a(0, 3);
+            const _Ty c5 = a(2, 2)*a(3, 3) - a(3, 2)*a(2, 3);
+            const _Ty c4 = a(2, 1)*a(3, 3) - a(3, 1)*a(2, 3);
+            const _Ty c3 = a(2, 1)*a(3, 2) - a(3, 1)*a(2, 2);
+            const _Ty c2 = a(2, 0)*a(3, 3) - a(3, 0)*a(2, 3);
+            const _Ty c1 = a(2, 0)*a(3, 2) - a(3, 0)*a(2, 2);
+            const _Ty c0 = a(2, 0)*a(3, 1) - a(3, 0)*a(2, 1);
+            return s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+        }
+      }
+      // b(i, j) = the adjugate over the determinant, returns the determinant; a singular <a> gives a zero <b>
+  template<
+      typename _Ty,
+      size_t size,
+      class _InTy,
+      class _OutTy>
+      TVD_NO_FP_CONTRACT constexpr _Ty small_inverse( _InTy const& a, _OutTy && b ) noexcept
+      {
+        TVD_NO_FP_CONTRACT_BODY
+        static_assert( size <= 4, "< tvd::inverse > : closed form up to 4x4" );
+        if constexpr( size == 1 ) {
+            const _Ty det = a(0, 0);
+            b(0, 0) = small_reciprocal( det );
+            return det;
+        } else if constexpr( size == 2 ) {
+            const _Ty det = small_determinant<_Ty, 2>( a );
+            const _Ty k = small_reciprocal( det );
+            b(0, 0) =  a(1, 1)*k;  b(0, 1) = -a(0, 1)*k;
+            b(1, 0) = -a(1, 0)*k;  b(1, 1) =  a(0, 0)*k;
+            return det;
+        } else if constexpr( size == 3 ) {
+            const _Ty det = small_determinant<_Ty, 3>( a );
+            const _Ty k = small_reciprocal( det );
+            b(0, 0) = ( a(1, 1)*a(2, 2) - a(1, 2)*a(2, 1) )*k;
+            b(0, 1) = ( a(0, 2)*a(2, 1) - a(0, 1)*a(2, 2) )*k;
+            b(0, 2) = ( a(0, 1)*a(1, 2) - a(0, 2)*a(1, 1) )*k;
+            b(1, 0) = ( a(1, 2)*a(2, 0) - a(1, 0)*a(2, 2) )*k;
+            b(1, 1) = ( a(0, 0)*a(2, 2) - a(0, 2)*a(2, 0) )*k;
+            b(1, 2) = ( a(0, 2)*a(1, 0) - a(0, 0)*a(1, 2) )*k;
+            b(2, 0) = ( a(1, 0)*a(2, 1) - a(1, 1)*a(2, 0) )*k;
+            b(2, 1) = ( a(0, 1)*a(2, 0) - a(0, 0)*a(2, 1) )*k;
+            b(2, 2) = ( a(0, 0)*a(1, 1) - a(0, 1)*a(1, 0) )*k;
+            return det;
+        } else {
+            const _Ty s0 = a(0, 0)*a(1, 1) - a(1, 0)*a(0, 1);
+            const _Ty s1 = a(0, 0)*a(1, 2) - a(1, 0)*a(0, 2);
+            const _Ty s2 = a(0, 0)*a(1, 3) - a(1, 0)*a(0, 3);
+            const _Ty s3 = a(0, 1)*a(1, 2) - a(1, 1)*a(0, 2);
+            const _Ty s4 = a(0, 1)*a(1, 3) - a(1, 1)*a(0, 3);
+            const _Ty s5 = a(0, 2)*a(1, 3) - a(1, 2)*a(0, 3);
+            const _Ty c5 = a(2, 2)*a(3, 3) - a(3, 2)*a(2, 3);
+            const _Ty c4 = a(2, 1)*a(3, 3) - a(3, 1)*a(2, 3);
+            const _Ty c3 = a(2, 1)*a(3, 2) - a(3, 1)*a(2, 2);
+            const _Ty c2 = a(2, 0)*a(3, 3) - a(3, 0)*a(2, 3);
+            const _Ty c1 = a(2, 0)*a(3, 2) - a(3, 0)*a(2, 2);
+            const _Ty c0 = a(2, 0)*a(3, 1) - a(3, 0)*a(2, 1);
+            const _Ty det = s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+            const _Ty k = small_reciprocal( det );
+            b(0, 0) = (  a(1, 1)*c5 - a(1, 2)*c4 + a(1, 3)*c3 )*k;
+            b(0, 1) = ( -a(0, 1)*c5 + a(0, 2)*c4 - a(0, 3)*c3 )*k;
+            b(0, 2) = (  a(3, 1)*s5 - a(3, 2)*s4 + a(3, 3)*s3 )*k;
+            b(0, 3) = ( -a(2, 1)*s5 + a(2, 2)*s4 - a(2, 3)*s3 )*k;
+            b(1, 0) = ( -a(1, 0)*c5 + a(1, 2)*c2 - a(1, 3)*c1 )*k;
+            b(1, 1) = (  a(0, 0)*c5 - a(0, 2)*c2 + a(0, 3)*c1 )*k;
+            b(1, 2) = ( -a(3, 0)*s5 + a(3, 2)*s2 - a(3, 3)*s1 )*k;
+            b(1, 3) = (  a(2, 0)*s5 - a(2, 2)*s2 + a(2, 3)*s1 )*k;
+            b(2, 0) = (  a(1, 0)*c4 - a(1, 1)*c2 + a(1, 3)*c0 )*k;
+            b(2, 1) = ( -a(0, 0)*c4 + a(0, 1)*c2 - a(0, 3)*c0 )*k;
+            b(2, 2) = (  a(3, 0)*s4 - a(3, 1)*s2 + a(3, 3)*s0 )*k;
+            b(2, 3) = ( -a(2, 0)*s4 + a(2, 1)*s2 - a(2, 3)*s0 )*k;
+            b(3, 0) = ( -a(1, 0)*c3 + a(1, 1)*c1 - a(1, 2)*c0 )*k;
+            b(3, 1) = (  a(0, 0)*c3 - a(0, 1)*c1 + a(0, 2)*c0 )*k;
+            b(3, 2) = ( -a(3, 0)*s3 + a(3, 1)*s1 - a(3, 2)*s0 )*k;
+            b(3, 3) = (  a(2, 0)*s3 - a(2, 1)*s1 + a(2, 2)*s0 )*k;
+            return det;
+        }
+      }
+    } // detail
+// closed forms up to 4x4
+template<
+    typename _Ty,
+    size_t size>
+    TVD_NO_FP_CONTRACT constexpr _Ty determinant( small_matrix<_Ty, size, size> const& a ) noexcept {
+      return detail::small_determinant<_Ty, size>( a );
+    }
+// adjugate over the determinant, throws for a singular matrix
+template<
+    typename _Ty,
+    size_t size>
+    TVD_NO_FP_CONTRACT constexpr small_matrix<_Ty, size, size> inverse( small_matrix<_Ty, size, size> const& a )
+    {
+      static_assert( std::is_floating_point_v<_Ty>, "< tvd::inverse > : <_Ty> must be floating point" );
+      small_matrix<_Ty, size, size> b;
+      if( detail::small_inverse<_Ty, size>( a, b ) == _Ty(0) ) {
+          throw TVD_EXCEPTION( "<tvd::inverse> : singular matrix" );
+      }
+      return b;
+    }
+// matrix interop : every row of <m> is multiplied by <t> in place, no temporary matrix
+template<
+    typename _Ty,
+    size_t col_size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> & operator *= ( matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> & m,
+                                                                   small_matrix<_Ty, col_size, col_size> const& t )
+    {
+      _Ty *row = m.data();
+      for( size_t i(0); i < m.size(); i++, row += col_size ) {
+          detail::small_row_product( row, t, row );
+      }
+      return m;
+    }
+
+template<
+    typename _Ty,
+    size_t col_size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> operator * ( matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> m,
+                                                                small_matrix<_Ty, col_size, col_size> const& t ) {
+      return m *= t;
+    }
+
+    namespace detail {
+      // square small matrices for 2d/3d affine transforms
+  template<typename _Ty>
+      using small_matrix2_t = small_matrix<_Ty, 2, 2>;
+  template<typename _Ty>
+      using small_matrix3_t = small_matrix<_Ty, 3, 3>;
+  template<typename _Ty>
+      using small_matrix4_t = small_matrix<_Ty, 4, 4>;
+    } // detail
+} // tvd
+#endif
@@ -0,0 +1,364 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the compressed sparse row matrix
+#pragma once
+#ifndef TVD_MATRIX_SPARSE_MATRIX_HPP
+#define TVD_MATRIX_SPARSE_MATRIX_HPP
+
+#include "tvd/exception.hpp"
+#include "tvd/thread_pool.hpp"
+#include "tvd/matrix/matrix.hpp"
+#include "tvd/matrix/matrix_view.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace tvd {
+
+template<typename _Ty>
+    struct sparse_triplet
+    {
+      size_t row;
+      size_t col;
+      _Ty    value;
+    };
+// rows x cols matrix in compressed sparse rows : the nonzeros of the row i are values()[offsets()[i], offsets()[i + 1])
+// at the columns columns()[...], sorted by column. <_IndexTy> is the column index type, 4 bytes by default
+template<
+    typename _Ty = float,
+    typename _IndexTy = uint32_t>
+    class sparse_matrix
+    {
+      static_assert( std::is_unsigned_v<_IndexTy>, "< tvd::sparse_matrix > : <_IndexTy> must be unsigned" );
+
+      size_t                rows_;
+      size_t                cols_;
+      std::vector<size_t>   offsets_;
+      std::vector<_IndexTy> columns_;
+      std::vector<_Ty>      values_;
+public :
+      using type_t  = _Ty;
+      using index_t = _IndexTy;
+
+      sparse_matrix()
+        : rows_( 0 )
+        , cols_( 0 )
+        , offsets_( 1, 0 )
+      {
+      }
+      // all zero
+      sparse_matrix( size_t rows, size_t cols )
+        : rows_( rows )
+        , cols_( cols )
+        , offsets_( rows + 1, 0 )
+      {
+        check_cols();
+      }
+      // duplicates are summed, the zeros they sum to are kept
+      sparse_matrix( size_t rows, size_t cols, std::vector<sparse_triplet<_Ty> > const& triplets )
+        : sparse_matrix( rows, cols )
+      {
+        for( auto const& t : triplets ) {
+            if( t.row >= rows_ || t.col >= cols_ ) {
+                throw TVD_EXCEPTION( "<sparse_matrix::sparse_matrix> : triplet out of range" );
+            }
+            offsets_[t.row + 1]++;
+        }
+        for( size_t i(0); i < rows_; i++ ) {
+            offsets_[i + 1] += offsets_[i];
+        }
+        columns_.resize( triplets.size() );
+        values_.resize( triplets.size() );
+        std::vector<size_t> fill( offsets_.begin(), offsets_.end() - 1 );
+        for( auto const& t : triplets ) {
+            columns_[fill[t.row]] = static_cast<_IndexTy>( t.col );
+            values_[fill[t.row]++] = t.value;
+        }
+
+        // sort every row by column and merge the duplicates in place
+        std::vector<std::pair<_IndexTy, _Ty> > row;
+        size_t out = 0;
+        for( size_t i(0); i < rows_; i++ )
+        {
+            row.clear();
+            for( size_t k( offsets_[i] ); k < offsets_[i + 1]; k++ ) {
+                row.push_back( { columns_[k], values_[k] } );
+            }
+            std::sort( row.begin(), row.end(), []( auto const& l, auto const& r ) { return l.first < r.first; } );
+            offsets_[i] = out;
+            for( size_t k(0); k < row.size(); k++ )
+            {
+                if( k > 0 && row[k].first == row[k - 1].first ) {
+                    values_[out - 1] += row[k].second;
+                    continue;
+                }
+                columns_[out] = row[k].first;
+                values_[out++] = row[k].second;
+            }
+        }
+        offsets_[rows_] = out;
+        columns_.resize( out );
+        values_.resize( out );
+      }
+      // the nonzeros of a dense matrix
+  template<
+      size_t col_size,
+      typename _ElemTraitsTy,
+      typename _AllocTy>
+      explicit sparse_matrix( matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> const& m )
+        : sparse_matrix( m.data(), m.size(), col_size )
+      {
+      }
+
+  template<class _ElemTraitsTy>
+      explicit sparse_matrix( matrix_view<_Ty, _ElemTraitsTy> const& m )
+        : sparse_matrix( m.data(), m.size(), m.csize() )
+      {
+      }
+
+      size_t rows() const noexcept {
+        return rows_;
+      }
+
+      size_t cols() const noexcept {
+        return cols_;
+      }
+
+      size_t nonzeros() const noexcept {
+        return values_.size();
+      }
+      // storage of the three arrays
+      size_t bytes() const noexcept {
+        return offsets_.size()*sizeof(size_t) + columns_.size()*sizeof(_IndexTy) + values_.size()*sizeof(_Ty);
+      }
+
+      const size_t* offsets() const noexcept {
+        return offsets_.data();
+      }
+
+      const _IndexTy* columns() const noexcept {
+        return columns_.data();
+      }
+
+      const _Ty* values() const noexcept {
+        return values_.data();
+      }
+      // the stored values can change, the pattern can not
+      _Ty* values() noexcept {
+        return values_.data();
+      }
+      // element (i, j), a binary search over the row
+      _Ty at( size_t i, size_t j ) const
+      {
+        if( i >= rows_ || j >= cols_ ) {
+            throw TVD_EXCEPTION( "<sparse_matrix::at> : out of range" );
+        }
+        const auto first = columns_.begin() + offsets_[i];
+        const auto last  = columns_.begin() + offsets_[i + 1];
+        const auto it = std::lower_bound( first, last, static_cast<_IndexTy>( j ) );
+        return it != last && *it == j ? values_[it - columns_.begin()] : _Ty(0);
+      }
+      // dense copy, <col_size> must be cols()
+  template<size_t col_size>
+      matrix<_Ty, col_size> dense() const
+      {
+        if( cols_ != col_size ) {
+            throw TVD_EXCEPTION( "<sparse_matrix::dense> : <cols> != <col_size>" );
+        }
+        matrix<_Ty, col_size> m( rows_ );
+        for( size_t i(0); i < rows_; i++ ) {
+            for( size_t k( offsets_[i] ); k < offsets_[i + 1]; k++ ) {
+                m.data()[i*col_size + columns_[k]] = values_[k];
+            }
+        }
+        return m;
+      }
+private :
+
+      sparse_matrix( const _Ty *data, size_t rows, size_t cols )
+        : sparse_matrix( rows, cols )
+      {
+        for( size_t i(0); i < rows_; i++ )
+        {
+            const _Ty *row = data + i*cols_;
+            for( size_t j(0); j < cols_; j++ ) {
+                if( row[j] != _Ty(0) ) {
+                    columns_.push_back( static_cast<_IndexTy>( j ) );
+                    values_.push_back( row[j] );
+                }
+            }
+            offsets_[i + 1] = values_.size();
+        }
+      }
+
+      void check_cols() const
+      {
+        if( cols_ > 0 && cols_ - 1 > std::numeric_limits<_IndexTy>::max() ) {
+            throw TVD_EXCEPTION( "<sparse_matrix::sparse_matrix> : <cols> does not fit <_IndexTy>" );
+        }
+      }
+    };
+
+    namespace detail {
+      // runs fn( first_row, last_row ) over row ranges of about the same nonzero count on the thread pool,
+      // the rows of a range are written by one thread only
+  template<
+      typename _Ty,
+      typename _IndexTy,
+      class _FnTy>
+      void sparse_rows_for( sparse_matrix<_Ty, _IndexTy> const& a, size_t work_per_nonzero, _FnTy && fn )
+      {
+        constexpr size_t min_work = 64*1024;
+        const size_t nnz   = a.nonzeros();
+        const size_t parts = std::max<size_t>( 1, std::min( 4*num_threads(), nnz*work_per_nonzero/min_work ) );
+        if( parts == 1 ) {
+            fn( size_t(0), a.rows() );
+            return;
+        }
+        // part <p> starts at the row holding the nonzero nnz*p/parts
+        auto boundary = [&]( size_t p ) -> size_t
+        {
+          if( p == 0 || p == parts ) {
+              return p == 0 ? 0 : a.rows();
+          }
+          const size_t *offsets = a.offsets();
+          return std::upper_bound( offsets, offsets + a.rows() + 1, nnz*p/parts ) - offsets - 1;
+        };
+        tvd::parallel_for( 0, parts, 1, [&]( size_t first, size_t last )
+        {
+          for( size_t p(first); p < last; p++ )
+          {
+              const size_t r0 = boundary( p ), r1 = boundary( p + 1 );
+              if( r0 < r1 ) {
+                  fn( r0, r1 );
+              }
+          }
+        } );
+      }
+      // y = A*x over raw arrays
+  template<
+      typename _Ty,
+      typename _IndexTy>
+      void spmv( sparse_matrix<_Ty, _IndexTy> const& a, const _Ty *x, _Ty *y )
+      {
+        sparse_rows_for( a, 1, [&]( size_t first, size_t last )
+        {
+          const size_t   *offsets = a.offsets();
+          const _IndexTy *columns = a.columns();
+          const _Ty      *values  = a.values();
+          for( size_t i(first); i < last; i++ )
+          {
+              _Ty sum = _Ty(0);
+              for( size_t k( offsets[i] ); k < offsets[i + 1]; k++ ) {
+                  sum += values[k]*x[columns[k]];
+              }
+              y[i] = sum;
+          }
+        } );
+      }
+      // C[rows x n] = A*B[cols x n], row-major with the row strides <ldb> and <ldc>; every nonzero adds
+      // a scaled row of B to a row of C, so the inner loop is contiguous
+  template<
+      typename _Ty,
+      typename _IndexTy>
+      void spmm( sparse_matrix<_Ty, _IndexTy> const& a, size_t n, const _Ty *b, size_t ldb, _Ty *c, size_t ldc )
+      {
+        sparse_rows_for( a, n, [&]( size_t first, size_t last )
+        {
+          const size_t   *offsets = a.offsets();
+          const _IndexTy *columns = a.columns();
+          const _Ty      *values  = a.values();
+          for( size_t i(first); i < last; i++ )
+          {
+              _Ty *c_row = c + i*ldc;
+              std::fill( c_row, c_row + n, _Ty(0) );
+              for( size_t k( offsets[i] ); k < offsets[i + 1]; k++ )
+              {
+                  const _Ty  v     = values[k];
+                  const _Ty *b_row = b + columns[k]*ldb;
+                  for( size_t j(0); j < n; j++ ) {
+                      c_row[j] += v*b_row[j];
+                  }
+              }
+          }
+        } );
+      }
+    } // detail
+// y = A*x, <y> is resized and keeps its capacity between calls
+template<
+    typename _Ty,
+    typename _IndexTy>
+    void multiply( sparse_matrix<_Ty, _IndexTy> const& a, std::vector<_Ty> const& x, std::vector<_Ty> & y )
+    {
+      if( x.size() != a.cols() ) {
+          throw TVD_EXCEPTION( "<tvd::multiply> : <x.size> != <a.cols>" );
+      }
+      if( &x == &y ) {
+          throw TVD_EXCEPTION( "<tvd::multiply> : <y> is <x>" );
+      }
+      y.resize( a.rows() );
+      detail::spmv( a, x.data(), y.data() );
+    }
+
+template<
+    typename _Ty,
+    typename _IndexTy>
+    std::vector<_Ty> operator * ( sparse_matrix<_Ty, _IndexTy> const& a, std::vector<_Ty> const& x )
+    {
+      std::vector<_Ty> y;
+      multiply( a, x, y );
+      return y;
+    }
+// C = A*B for a dense <B> of a.cols() rows
+template<
+    typename _Ty,
+    typename _IndexTy,
+    size_t col_size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    void multiply( sparse_matrix<_Ty, _IndexTy> const& a, matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> const& b,
+                   matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> & c )
+    {
+      if( b.size() != a.cols() ) {
+          throw TVD_EXCEPTION( "<tvd::multiply> : <b.size> != <a.cols>" );
+      }
+      if( &b == &c ) {
+          throw TVD_EXCEPTION( "<tvd::multiply> : <c> is <b>" );
+      }
+      if( c.size() != a.rows() ) {
+          c = matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy>( a.rows() );
+      }
+      detail::spmm( a, col_size, b.data(), col_size, c.data(), col_size );
+    }
+
+template<
+    typename _Ty,
+    typename _IndexTy,
+    size_t col_size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> operator * ( sparse_matrix<_Ty, _IndexTy> const& a,
+                                                                matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> const& b )
+    {
+      matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> c;
+      multiply( a, b, c );
+      return c;
+    }
+// C = A*B for a borrowed <B>, <col_size> must be b.csize()
+template<
+    size_t col_size,
+    typename _Ty,
+    typename _IndexTy,
+    class _ElemTraitsTy>
+    matrix<_Ty, col_size> multiply( sparse_matrix<_Ty, _IndexTy> const& a, matrix_view<_Ty, _ElemTraitsTy> const& b )
+    {
+      if( b.size() != a.cols() || b.csize() != col_size ) {
+          throw TVD_EXCEPTION( "<tvd::multiply> : <b> is not <a.cols> x <col_size>" );
+      }
+      matrix<_Ty, col_size> c( a.rows() );
+      detail::spmm( a, col_size, b.data(), col_size, c.data(), col_size );
+      return c;
+    }
+} // tvd
+#endif
@@ -0,0 +1,375 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the strided matrix view
+#pragma once
+#ifndef TVD_MATRIX_STRIDED_VIEW_HPP
+#define TVD_MATRIX_STRIDED_VIEW_HPP
+
+#include "tvd/exception.hpp"
+#include "tvd/matrix/gemm.hpp"
+#include "tvd/matrix/matrix.hpp"
+#include "tvd/matrix/matrix_view.hpp"
+#include "tvd/matrix/simd.hpp"
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace tvd {
+// rows x cols elements at data()[i*row_stride() + j*col_stride()] of a buffer owned elsewhere; blocks, column
+// ranges and the transpose are views of the same buffer, nothing is copied. copying a view rebinds it like
+// row_ref, the operators write through to the buffer. <_Ty> is const for a read-only view
+template<typename _Ty>
+    class strided_view
+    {
+public :
+      using type_t    = std::remove_const_t<_Ty>;
+      using pointer_t = _Ty*;
+private :
+      _Ty      *data_;
+      size_t    rows_;
+      size_t    cols_;
+      ptrdiff_t row_stride_;
+      ptrdiff_t col_stride_;
+public :
+      constexpr strided_view() noexcept
+        : data_( nullptr )
+        , rows_( 0 )
+        , cols_( 0 )
+        , row_stride_( 0 )
+        , col_stride_( 0 )
+      {
+      }
+      // a dense row-major buffer by default
+      constexpr strided_view( _Ty *data, size_t rows, size_t cols ) noexcept
+        : strided_view( data, rows, cols, static_cast<ptrdiff_t>( cols ), 1 )
+      {
+      }
+
+      constexpr strided_view( _Ty *data, size_t rows, size_t cols, ptrdiff_t row_stride, ptrdiff_t col_stride ) noexcept
+        : data_( data )
+        , rows_( rows )
+        , cols_( cols )
+        , row_stride_( row_stride )
+        , col_stride_( col_stride )
+      {
+      }
+
+  template<
+      typename Ty,
+      std::enable_if_t<std::is_same_v<const Ty, _Ty> && !std::is_same_v<Ty, _Ty>, bool> = true>
+      constexpr strided_view( strided_view<Ty> const& other ) noexcept
+        : strided_view( other.data(), other.rows(), other.cols(), other.row_stride(), other.col_stride() )
+      {
+      }
+
+      constexpr pointer_t data() const noexcept {
+        return data_;
+      }
+
+      constexpr size_t rows() const noexcept {
+        return rows_;
+      }
+
+      constexpr size_t cols() const noexcept {
+        return cols_;
+      }
+      // rows, as matrix::size()
+      constexpr size_t size() const noexcept {
+        return rows_;
+      }
+
+      constexpr size_t csize() const noexcept {
+        return cols_;
+      }
+
+      constexpr bool empty() const noexcept {
+        return rows_ == 0 || cols_ == 0;
+      }
+
+      constexpr ptrdiff_t row_stride() const noexcept {
+        return row_stride_;
+      }
+
+      constexpr ptrdiff_t col_stride() const noexcept {
+        return col_stride_;
+      }
+      // the elements of every row are adjacent
+      constexpr bool contiguous_rows() const noexcept {
+        return col_stride_ == 1;
+      }
+
+      constexpr _Ty & operator () ( size_t i, size_t j ) const noexcept {
+        return data_[static_cast<ptrdiff_t>( i )*row_stride_ + static_cast<ptrdiff_t>( j )*col_stride_];
+      }
+
+      _Ty & at( size_t i, size_t j ) const
+      {
+        if( i >= rows_ || j >= cols_ ) {
+            throw TVD_EXCEPTION( "<strided_view::at> : bad access" );
+        }
+        return ( *this )( i, j );
+      }
+      // <rows> x <cols> elements from (i, j)
+      strided_view block( size_t i, size_t j, size_t rows, size_t cols ) const
+      {
+        if( i + rows > rows_ || j + cols > cols_ ) {
+            throw TVD_EXCEPTION( "<strided_view::block> : the block is out of the view" );
+        }
+        return { rows && cols ? &( *this )( i, j ) : data_, rows, cols, row_stride_, col_stride_ };
+      }
+
+      strided_view row_range( size_t i, size_t count ) const {
+        return block( i, 0, count, cols_ );
+      }
+
+      strided_view columns( size_t j, size_t count ) const {
+        return block( 0, j, rows_, count );
+      }
+      // every <step>-th column from <j>
+      strided_view columns( size_t j, size_t count, size_t step ) const
+      {
+        if( step == 0 || ( count && j + ( count - 1 )*step >= cols_ ) ) {
+            throw TVD_EXCEPTION( "<strided_view::columns> : the columns are out of the view" );
+        }
+        return { count ? &( *this )( 0, j ) : data_, rows_, count, row_stride_, col_stride_*static_cast<ptrdiff_t>( step ) };
+      }
+
+      strided_view column( size_t j ) const {
+        return columns( j, 1 );
+      }
+      // swaps the strides
+      constexpr strided_view transpose() const noexcept {
+        return { data_, cols_, rows_, col_stride_, row_stride_ };
+      }
+      // element-wise, <other> is a view of the same shape; it must not overlap *this other than element for element
+  template<typename Ty>
+      strided_view const& assign( strided_view<Ty> const& other ) const
+      {
+        check_shape( other, "<strided_view::assign> : <other> has another shape" );
+        for_each_row( other, []( _Ty *dst, const type_t *src, size_t n, ptrdiff_t ds, ptrdiff_t ss ) {
+          for( size_t j(0); j < n; j++ ) {
+              dst[j*ds] = src[j*ss];
+          }
+        } );
+        return *this;
+      }
+
+  template<typename Ty>
+      strided_view const& operator += ( strided_view<Ty> const& other ) const
+      {
+        check_shape( other, "<strided_view::operator+=> : <other> has another shape" );
+        for_each_row( other, []( _Ty *dst, const type_t *src, size_t n, ptrdiff_t ds, ptrdiff_t ss )
+        {
+          if( ds == 1 && ss == 1 ) {
+              simd::add( dst, src, n );
+              return;
+          }
+          for( size_t j(0); j < n; j++ ) {
+              dst[j*ds] += src[j*ss];
+          }
+        } );
+        return *this;
+      }
+
+  template<typename Ty>
+      strided_view const& operator -= ( strided_view<Ty> const& other ) const
+      {
+        check_shape( other, "<strided_view::operator-=> : <other> has another shape" );
+        for_each_row( other, []( _Ty *dst, const type_t *src, size_t n, ptrdiff_t ds, ptrdiff_t ss )
+        {
+          if( ds == 1 && ss == 1 ) {
+              simd::sub( dst, src, n );
+              return;
+          }
+          for( size_t j(0); j < n; j++ ) {
+              dst[j*ds] -= src[j*ss];
+          }
+        } );
+        return *this;
+      }
+
+      strided_view const& operator *= ( type_t const& value ) const
+      {
+        for( size_t i(0); i < rows_; i++ )
+        {
+            _Ty *row = data_ + static_cast<ptrdiff_t>( i )*row_stride_;
+            if( col_stride_ == 1 ) {
+                simd::scale( row, value, cols_ );
+                continue;
+            }
+            for( size_t j(0); j < cols_; j++ ) {
+                row[static_cast<ptrdiff_t>( j )*col_stride_] *= value;
+            }
+        }
+        return *this;
+      }
+
+      strided_view const& operator /= ( type_t const& value ) const
+      {
+        if( value <= 0 ) {
+            throw TVD_EXCEPTION( "bad operation : value = 0" );
+        }
+        return *this *= type_t( 1.0/value );
+      }
+
+  template<typename Ty>
+      bool operator == ( strided_view<Ty> const& other ) const
+      {
+        if( rows_ != other.rows() || cols_ != other.cols() ) {
+            return false;
+        }
+        for( size_t i(0); i < rows_; i++ ) {
+            for( size_t j(0); j < cols_; j++ ) {
+                if( ( *this )( i, j ) != other( i, j ) ) {
+                    return false;
+                }
+            }
+        }
+        return true;
+      }
+
+  template<typename Ty>
+      bool operator != ( strided_view<Ty> const& other ) const {
+        return !( *this == other );
+      }
+private :
+
+  template<typename Ty>
+      void check_shape( strided_view<Ty> const& other, const char *message ) const
+      {
+        if( rows_ != other.rows() || cols_ != other.cols() ) {
+            throw TVD_EXCEPTION( message );
+        }
+      }
+      // fn( dst row, src row, cols, dst col stride, src col stride ) for every row
+  template<
+      typename Ty,
+      class _FnTy>
+      void for_each_row( strided_view<Ty> const& other, _FnTy && fn ) const
+      {
+        for( size_t i(0); i < rows_; i++ ) {
+            fn( data_ + static_cast<ptrdiff_t>( i )*row_stride_,
+                other.data() + static_cast<ptrdiff_t>( i )*other.row_stride(),
+                cols_, col_stride_, other.col_stride() );
+        }
+      }
+    };
+// views of a whole matrix
+template<
+    typename _Ty,
+    size_t col_size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    strided_view<_Ty> make_strided_view( matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> & m ) noexcept {
+      return { m.data(), m.size(), col_size };
+    }
+
+template<
+    typename _Ty,
+    size_t col_size,
+    typename _ElemTraitsTy,
+    typename _AllocTy>
+    strided_view<const _Ty> make_strided_view( matrix<_Ty, col_size, _ElemTraitsTy, _AllocTy> const& m ) noexcept {
+      return { m.data(), m.size(), col_size };
+    }
+
+template<
+    typename _Ty,
+    class _ElemTraitsTy>
+    strided_view<const _Ty> make_strided_view( matrix_view<_Ty, _ElemTraitsTy> const& m ) noexcept {
+      return { m.data(), m.size(), m.csize() };
+    }
+// min value in the view column, overloads the generic algorithm.hpp version without walking a flat range
+template<typename _Ty>
+    std::remove_const_t<_Ty> min( strided_view<_Ty> const& m, size_t j_pos )
+    {
+      if( m.empty() ) {
+          throw TVD_EXCEPTION( "<tvd::min> : <view> is empty" );
+      }
+      if( m.csize() <= j_pos ) {
+          throw TVD_EXCEPTION( "<tvd::min> : <view.csize> <= <j_pos>" );
+      }
+      auto min = m( 0, j_pos );
+      for( size_t i(1); i < m.rows(); i++ ) {
+          if( min > m( i, j_pos ) ) min = m( i, j_pos );
+      }
+      return min;
+    }
+// max value in the view column
+template<typename _Ty>
+    std::remove_const_t<_Ty> max( strided_view<_Ty> const& m, size_t j_pos )
+    {
+      if( m.empty() ) {
+          throw TVD_EXCEPTION( "<tvd::max> : <view> is empty" );
+      }
+      if( m.csize() <= j_pos ) {
+          throw TVD_EXCEPTION( "<tvd::max> : <view.csize> <= <j_pos>" );
+      }
+      auto max = m( 0, j_pos );
+      for( size_t i(1); i < m.rows(); i++ ) {
+          if( max < m( i, j_pos ) ) max = m( i, j_pos );
+      }
+      return max;
+    }
+// min & max value in the view column, one pass
+template<typename _Ty>
+    std::pair<std::remove_const_t<_Ty>, std::remove_const_t<_Ty> > minmax( strided_view<_Ty> const& m, size_t j_pos )
+    {
+      if( m.empty() ) {
+          throw TVD_EXCEPTION( "<tvd::minmax> : <view> is empty" );
+      }
+      if( m.csize() <= j_pos ) {
+          throw TVD_EXCEPTION( "<tvd::minmax> : <view.csize> <= <j_pos>" );
+      }
+      std::pair<std::remove_const_t<_Ty>, std::remove_const_t<_Ty> > r( m( 0, j_pos ), m( 0, j_pos ) );
+      for( size_t i(1); i < m.rows(); i++ )
+      {
+          const auto x = m( i, j_pos );
+          if( r.first  > x ) r.first  = x;
+          if( r.second < x ) r.second = x;
+      }
+      return r;
+    }
+// C = A*B straight from the strides, <c> must not overlap <a> or <b>
+template<
+    typename _Ty,
+    typename _LeftTy,
+    typename _RightTy>
+    void multiply( strided_view<_LeftTy> const& a, strided_view<_RightTy> const& b, strided_view<_Ty> const& c )
+    {
+      static_assert(
+        std::is_same_v<std::remove_const_t<_LeftTy>, _Ty> && std::is_same_v<std::remove_const_t<_RightTy>, _Ty>,
+        "< tvd::multiply > : the views have different element types"
+      );
+      if( a.cols() != b.rows() ) {
+          throw TVD_EXCEPTION( "<tvd::multiply> : col1 != row2" );
+      }
+      if( c.rows() != a.rows() || c.cols() != b.cols() ) {
+          throw TVD_EXCEPTION( "<tvd::multiply> : <c> is not <a.rows> x <b.cols>" );
+      }
+      for( size_t i(0); i < c.rows(); i++ ) {
+          for( size_t j(0); j < c.cols(); j++ ) {
+              c( i, j ) = _Ty(0);
+          }
+      }
+      detail::gemm<_Ty>( a.rows(), b.cols(), a.cols(), _Ty(1),
+                         a.data(), a.row_stride(), a.col_stride(),
+                         b.data(), b.row_stride(), b.col_stride(),
+                         c.data(), c.row_stride(), c.col_stride() );
+    }
+// A*B into a new matrix of <col_size> columns
+template<
+    size_t col_size,
+    typename _LeftTy,
+    typename _RightTy>
+    matrix<std::remove_const_t<_LeftTy>, col_size> multiply( strided_view<_LeftTy> const& a, strided_view<_RightTy> const& b )
+    {
+      if( b.cols() != col_size ) {
+          throw TVD_EXCEPTION( "<tvd::multiply> : <b.cols> != <col_size>" );
+      }
+      matrix<std::remove_const_t<_LeftTy>, col_size> c( a.rows() );
+      multiply( a, b, make_strided_view( c ) );
+      return c;
+    }
+} // tvd
+#endif
@@ -0,0 +1,182 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the thread-local scratch arena for temporaries
+#pragma once
+#ifndef TVD_SCRATCH_ARENA_HPP
+#define TVD_SCRATCH_ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace tvd {
+// bump allocator : allocation moves a pointer, release( mark ) rewinds it; chunks are kept for reuse
+// until the owning thread exits, so steady-state temporaries never reach malloc
+    class scratch_arena
+    {
+      struct chunk
+      {
+        std::byte *data;
+        size_t     size;
+      };
+
+      std::vector<chunk> chunks_;
+      size_t             current_;
+      size_t             offset_;
+public :
+      static constexpr size_t min_chunk = 64*1024;
+      static constexpr size_t alignment = 64;
+
+      struct marker
+      {
+        size_t chunk;
+        size_t offset;
+      };
+
+      scratch_arena()
+        : current_( 0 )
+        , offset_( 0 )
+      {
+      }
+
+      scratch_arena( scratch_arena const& ) = delete;
+      scratch_arena & operator = ( scratch_arena const& ) = delete;
+
+      ~scratch_arena()
+      {
+        for( auto & c : chunks_ ) {
+            ::operator delete( c.data, std::align_val_t( alignment ) );
+        }
+      }
+      // arena of the calling thread
+      static scratch_arena & local()
+      {
+        thread_local scratch_arena arena;
+        return arena;
+      }
+
+      void* allocate( size_t bytes, size_t align = alignof(std::max_align_t) )
+      {
+        align = std::max<size_t>( align, 1 );
+        if( !chunks_.empty() ) {
+            if( void *p = bump( chunks_[current_], bytes, align ) ) {
+                return p;
+            }
+            // the next chunk is reused when it fits, otherwise a larger one is put in front of it
+            if( current_ + 1 < chunks_.size() && chunks_[current_ + 1].size >= bytes + align ) {
+                current_++;
+                offset_ = 0;
+                return bump( chunks_[current_], bytes, align );
+            }
+        }
+        const size_t size = std::max( { min_chunk, bytes + align, chunks_.empty() ? size_t(0) : 2*chunks_[current_].size } );
+        chunk c { static_cast<std::byte*>( ::operator new( size, std::align_val_t( alignment ) ) ), size };
+        const size_t at = chunks_.empty() ? 0 : current_ + 1;
+        chunks_.insert( chunks_.begin() + at, c );
+        current_ = at;
+        offset_  = 0;
+        return bump( chunks_[current_], bytes, align );
+      }
+
+  template<typename _Ty>
+      _Ty* allocate( size_t n ) {
+        return static_cast<_Ty*>( allocate( n*sizeof(_Ty), alignof(_Ty) ) );
+      }
+      // only the most recent block is given back, anything else waits for release()
+      void deallocate( void *p, size_t bytes ) noexcept
+      {
+        if( chunks_.empty() ) {
+            return;
+        }
+        std::byte *top = chunks_[current_].data + offset_;
+        if( static_cast<std::byte*>( p ) + bytes == top ) {
+            offset_ -= bytes;
+        }
+      }
+
+      marker mark() const noexcept {
+        return { current_, offset_ };
+      }
+
+      void release( marker const& m ) noexcept
+      {
+        current_ = m.chunk;
+        offset_  = m.offset;
+      }
+      // bytes held by the arena
+      size_t capacity() const noexcept
+      {
+        size_t size(0);
+        for( auto const& c : chunks_ ) {
+            size += c.size;
+        }
+        return size;
+      }
+private :
+
+      void* bump( chunk const& c, size_t bytes, size_t align ) noexcept
+      {
+        const auto base  = reinterpret_cast<std::uintptr_t>( c.data );
+        const size_t off = ( ( base + offset_ + align - 1 )/align )*align - base;
+        if( off + bytes > c.size ) {
+            return nullptr;
+        }
+        offset_ = off + bytes;
+        return c.data + off;
+      }
+    };
+// everything allocated from the calling thread's arena inside the scope is released at its end
+    class scratch_scope
+    {
+      scratch_arena          & arena_;
+      scratch_arena::marker    mark_;
+public :
+      scratch_scope()
+        : arena_( scratch_arena::local() )
+        , mark_( arena_.mark() )
+      {
+      }
+
+      scratch_scope( scratch_scope const& ) = delete;
+      scratch_scope & operator = ( scratch_scope const& ) = delete;
+
+      ~scratch_scope() {
+        arena_.release( mark_ );
+      }
+    };
+// std allocator over the calling thread's arena, containers using it must not outlive
+// the enclosing scratch_scope nor move to another thread
+template<typename _Ty>
+    class scratch_allocator
+    {
+public :
+      using value_type = _Ty;
+
+      scratch_allocator() noexcept = default;
+
+  template<typename Ty>
+      scratch_allocator( scratch_allocator<Ty> const& ) noexcept
+      {
+      }
+
+      _Ty* allocate( size_t n ) {
+        return scratch_arena::local().allocate<_Ty>( n );
+      }
+
+      void deallocate( _Ty *p, size_t n ) noexcept {
+        scratch_arena::local().deallocate( p, n*sizeof(_Ty) );
+      }
+
+  template<typename Ty>
+      bool operator == ( scratch_allocator<Ty> const& ) const noexcept {
+        return true;
+      }
+
+  template<typename Ty>
+      bool operator != ( scratch_allocator<Ty> const& ) const noexcept {
+        return false;
+      }
+    };
+} // tvd
+#endif
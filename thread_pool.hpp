@@ -0,0 +1,301 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the work-stealing thread pool
+#pragma once
+#ifndef TVD_THREAD_POOL_HPP
+#define TVD_THREAD_POOL_HPP
+
+#include "tvd/exception.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tvd {
+// every worker owns a deque : it pops its own tasks from the back and steals from the front of the others,
+// the thread that calls parallel_for takes part in the work until its tasks are done
+    class thread_pool
+    {
+      struct job
+      {
+        void (*invoke)( void*, size_t, size_t );
+        void *fn;
+        std::atomic<size_t> remaining;
+        std::mutex          error_mutex;
+        std::exception_ptr  error;
+      };
+
+      struct task
+      {
+        job   *owner;
+        size_t begin;
+        size_t end;
+      };
+
+      struct task_queue
+      {
+        std::mutex       mutex;
+        std::deque<task> tasks;
+      };
+
+      std::vector<std::unique_ptr<task_queue> > queues_;
+      std::vector<std::thread>                  workers_;
+      std::mutex                                wake_mutex_;
+      std::condition_variable                   wake_;
+      std::atomic<size_t>                       pending_;
+      std::atomic<size_t>                       next_queue_;
+      bool                                      stop_;
+public :
+      // <threads> counts the calling thread, so <threads> - 1 workers are started
+      explicit thread_pool( size_t threads = default_threads() )
+        : pending_( 0 )
+        , next_queue_( 0 )
+        , stop_( false )
+      {
+        start( threads );
+      }
+
+      thread_pool( thread_pool const& ) = delete;
+      thread_pool & operator = ( thread_pool const& ) = delete;
+
+      ~thread_pool() {
+        stop();
+      }
+
+      static size_t default_threads() noexcept {
+        return std::max<size_t>( 1, std::thread::hardware_concurrency() );
+      }
+      // pool shared by the library kernels
+      static thread_pool & instance()
+      {
+        static thread_pool pool;
+        return pool;
+      }
+
+      size_t size() const noexcept {
+        return workers_.size() + 1;
+      }
+      // must not be called while the pool is running tasks
+      void resize( size_t threads )
+      {
+        if( threads == 0 ) {
+            threads = default_threads();
+        }
+        if( threads == size() ) {
+            return;
+        }
+        stop();
+        start( threads );
+      }
+      // calls f( chunk_begin, chunk_end ) over [begin, end) split into chunks of <grain>, returns when all are done
+  template<class _FnTy>
+      void parallel_for( size_t begin, size_t end, size_t grain, _FnTy && fn )
+      {
+        if( begin >= end ) {
+            return;
+        }
+        grain = std::max<size_t>( grain, 1 );
+        const size_t chunks = ( end - begin + grain - 1 )/grain;
+        if( workers_.empty() || chunks == 1 ) {
+            fn( begin, end );
+            return;
+        }
+
+        using fn_t = std::remove_reference_t<_FnTy>;
+        job j;
+        j.invoke = []( void *fn, size_t b, size_t e ) { ( *static_cast<fn_t*>( fn ) )( b, e ); };
+        j.fn = const_cast<void*>( static_cast<const void*>( std::addressof( fn ) ) );
+        j.remaining.store( chunks, std::memory_order_relaxed );
+
+        {
+            std::lock_guard<std::mutex> lock( wake_mutex_ );
+            pending_.fetch_add( chunks, std::memory_order_release );
+        }
+        const size_t queues = queues_.size();
+        size_t q = next_queue_.fetch_add( 1, std::memory_order_relaxed );
+        for( size_t c(0); c < chunks; c++, q++ )
+        {
+            const size_t b = begin + c*grain;
+            auto & queue = *queues_[q%queues];
+            std::lock_guard<std::mutex> lock( queue.mutex );
+            queue.tasks.push_back( { &j, b, std::min( end, b + grain ) } );
+        }
+        wake_.notify_all();
+
+        while( j.remaining.load( std::memory_order_acquire ) != 0 )
+        {
+            task t;
+            if( take( t, worker_index() ) ) {
+                run( t );
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        if( j.error ) {
+            std::rethrow_exception( j.error );
+        }
+      }
+private :
+
+      static size_t & worker_index()
+      {
+        thread_local size_t index = 0;
+        return index;
+      }
+
+      void start( size_t threads )
+      {
+        stop_ = false;
+        const size_t workers = std::max<size_t>( threads, 1 ) - 1;
+        queues_.clear();
+        for( size_t i(0); i < std::max<size_t>( workers, 1 ); i++ ) {
+            queues_.push_back( std::make_unique<task_queue>() );
+        }
+        for( size_t i(0); i < workers; i++ ) {
+            workers_.emplace_back( [this, i] { worker_loop( i ); } );
+        }
+      }
+
+      void stop()
+      {
+        {
+            std::lock_guard<std::mutex> lock( wake_mutex_ );
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for( auto & worker : workers_ ) {
+            worker.join();
+        }
+        workers_.clear();
+      }
+      // own queue from the back first, then the others from the front
+      bool take( task & t, size_t own )
+      {
+        const size_t queues = queues_.size();
+        {
+            auto & queue = *queues_[own%queues];
+            std::lock_guard<std::mutex> lock( queue.mutex );
+            if( !queue.tasks.empty() ) {
+                t = queue.tasks.back();
+                queue.tasks.pop_back();
+                pending_.fetch_sub( 1, std::memory_order_relaxed );
+                return true;
+            }
+        }
+        for( size_t i(1); i < queues; i++ )
+        {
+            auto & queue = *queues_[( own + i )%queues];
+            std::lock_guard<std::mutex> lock( queue.mutex );
+            if( !queue.tasks.empty() ) {
+                t = queue.tasks.front();
+                queue.tasks.pop_front();
+                pending_.fetch_sub( 1, std::memory_order_relaxed );
+                return true;
+            }
+        }
+        return false;
+      }
+
+      static void run( task const& t )
+      {
+        try {
+            t.owner->invoke( t.owner->fn, t.begin, t.end );
+        } catch( ... ) {
+            std::lock_guard<std::mutex> lock( t.owner->error_mutex );
+            if( !t.owner->error ) {
+                t.owner->error = std::current_exception();
+            }
+        }
+        t.owner->remaining.fetch_sub( 1, std::memory_order_acq_rel );
+      }
+
+      void worker_loop( size_t index )
+      {
+        worker_index() = index;
+        for( ;; )
+        {
+            task t;
+            if( take( t, index ) ) {
+                run( t );
+                continue;
+            }
+            std::unique_lock<std::mutex> lock( wake_mutex_ );
+            wake_.wait( lock, [this] {
+              return stop_ || pending_.load( std::memory_order_acquire ) != 0;
+            } );
+            if( stop_ ) {
+                return;
+            }
+        }
+      }
+    };
+// number of threads the library kernels use, 0 restores the hardware default
+    inline void set_num_threads( size_t threads ) {
+      thread_pool::instance().resize( threads );
+    }
+
+    inline size_t num_threads() {
+      return thread_pool::instance().size();
+    }
+// the calling thread's <_Ty> while no other lease of it is alive on this thread, a new <_Ty> otherwise.
+// a thread waiting in parallel_for runs tasks of other jobs, so a per-thread buffer held across
+// a parallel_for is leased : a task stolen meanwhile gets a buffer of its own instead of this one
+template<class _Ty>
+    class local_lease
+    {
+      struct slot
+      {
+        _Ty  value;
+        bool leased = false;
+      };
+
+      slot                *slot_;
+      std::unique_ptr<_Ty> own_;
+
+      static slot & local()
+      {
+        thread_local slot s;
+        return s;
+      }
+public :
+      local_lease()
+        : slot_( &local() )
+      {
+        if( slot_->leased ) {
+            slot_ = nullptr;
+            own_  = std::make_unique<_Ty>();
+        } else {
+            slot_->leased = true;
+        }
+      }
+
+      local_lease( local_lease const& ) = delete;
+      local_lease & operator = ( local_lease const& ) = delete;
+
+      ~local_lease()
+      {
+        if( slot_ ) {
+            slot_->leased = false;
+        }
+      }
+
+      _Ty & operator * () const noexcept {
+        return slot_ ? slot_->value : *own_;
+      }
+
+      _Ty * operator -> () const noexcept {
+        return &**this;
+      }
+    };
+// shortcut over the shared pool
+template<class _FnTy>
+    void parallel_for( size_t begin, size_t end, size_t grain, _FnTy && fn ) {
+      thread_pool::instance().parallel_for( begin, end, grain, std::forward<_FnTy>( fn ) );
+    }
+} // tvd
+#endif
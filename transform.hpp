@@ -0,0 +1,134 @@
+// c++17 @Tarnakin V.D.
+//this header has a description of the composable affine transform
+#pragma once
+#ifndef TVD_TRANSFORM_HPP
+#define TVD_TRANSFORM_HPP
+
+#include "tvd/thread_pool.hpp"
+#include "tvd/matrix/matrix.hpp"
+#include "tvd/matrix/small_matrix.hpp"
+
+#include <cmath>
+#include <vector>
+
+namespace tvd {
+// records move/scale/rotate steps and applies them to the point matrix as one 3x3 matrix in a single pass :
+//   affine_transform<float>().move( 10, 0 ).rotate( a, 0, 0 ).scale( 2, 2 ).apply( points );
+// the steps mean the same as the free functions of math.hpp called in the same order
+template<typename _Ty>
+    class affine_transform
+    {
+      static_assert(
+        std::is_arithmetic_v<_Ty>,
+        "< tvd::affine_transform<_Ty> > : <_Ty> must be arithmetic"
+      );
+
+      enum class kind_t { matrix, scale_first };
+
+      struct step
+      {
+        kind_t                        kind;
+        detail::small_matrix3_t<_Ty>  m;
+        _Ty                           k_x;
+        _Ty                           k_y;
+      };
+
+      std::vector<step> steps_;
+public :
+      using matrix_t     = detail::small_matrix3_t<_Ty>;
+      using points_t     = detail::matrix_3xn_t<_Ty>;
+      // point matrices with fewer rows stay on the calling thread
+      static constexpr size_t parallel_rows = 64*1024;
+
+      affine_transform & move( _Ty x0, _Ty y0, _Ty x1, _Ty y1 )
+      {
+        return then( matrix_t
+        {   1,          0,       0,
+            0,          1,       0,
+            x1 - x0,    y1 - y0, 1   } );
+      }
+
+      affine_transform & move( _Ty x, _Ty y ) {
+        return move( _Ty(0), _Ty(0), x, y );
+      }
+      // pivot is the first point as it is when the step is reached
+      affine_transform & scale( _Ty k_x, _Ty k_y )
+      {
+        steps_.push_back( { kind_t::scale_first, matrix_t(), k_x, k_y } );
+        return *this;
+      }
+
+      affine_transform & scale( _Ty k_x, _Ty k_y, _Ty x, _Ty y )
+      {
+        return then( matrix_t
+        {   k_x,            0,              0,
+            0,              k_y,            0,
+            x*(1 - k_x),    y*(1 - k_y),    1   } );
+      }
+
+      affine_transform & rotate( double r_ang, _Ty x, _Ty y )
+      {
+        const _Ty sin = std::sin(r_ang);
+        const _Ty cos = std::cos(r_ang);
+        return then( matrix_t
+        {   cos,                 sin,                 0,
+           -sin,                 cos,                 0,
+            x*(1 - cos) + y*sin, y*(1 - cos) - x*sin, 1   } );
+      }
+      // any row-vector transform, applied after the recorded steps
+      affine_transform & then( matrix_t const& m )
+      {
+        if( !steps_.empty() && steps_.back().kind == kind_t::matrix ) {
+            steps_.back().m *= m;
+        } else {
+            steps_.push_back( { kind_t::matrix, m, _Ty(0), _Ty(0) } );
+        }
+        return *this;
+      }
+
+      void clear() noexcept {
+        steps_.clear();
+      }
+      // single matrix of the chain, <first> is the first point the pivot-less scale steps refer to
+      matrix_t compose( vector<_Ty, 3> const& first = vector<_Ty, 3>() ) const
+      {
+        matrix_t m = matrix_t::identity();
+        for( auto const& s : steps_ )
+        {
+            if( s.kind == kind_t::matrix ) {
+                m *= s.m;
+                continue;
+            }
+            _Ty p[3];
+            detail::small_row_product( first.data(), m, p );
+            m *= matrix_t
+            {   s.k_x,              0,                  0,
+                0,                  s.k_y,              0,
+                p[0]*(1 - s.k_x),   p[1]*(1 - s.k_y),   1   };
+        }
+        return m;
+      }
+      // one pass over the rows, split over the shared thread pool for large matrices
+      void apply( points_t & points, bool parallel = true ) const
+      {
+        if( points.size() == 0 || steps_.empty() ) {
+            return;
+        }
+        const matrix_t m = compose( vector<_Ty, 3>( points[0] ) );
+        _Ty *data = points.data();
+
+        auto rows = [&m, data]( size_t first, size_t last )
+        {
+          for( size_t i(first); i < last; i++ ) {
+              detail::small_row_product( data + i*3, m, data + i*3 );
+          }
+        };
+        if( parallel && points.size() >= parallel_rows ) {
+            tvd::parallel_for( 0, points.size(), parallel_rows/4, rows );
+        } else {
+            rows( 0, points.size() );
+        }
+      }
+    };
+} // tvd
+#endif
@@ -30,6 +30,20 @@ template<
       using reference_t = _RefTy;
     };
 
+template<
+    typename _ContainerTy,
+    typename = void>
+    struct container_allocator
+    {
+      using type = void;
+    };
+
+template<typename _ContainerTy>
+    struct container_allocator<_ContainerTy, std::void_t<typename _ContainerTy::allocator_type> >
+    {
+      using type = typename _ContainerTy::allocator_type;
+    };
+
 template<
     typename _ElemTraitsTy,
     typename _ContainerTy>
@@ -37,6 +51,8 @@ template<
     {
       using elem_traits_t = _ElemTraitsTy;
       using container_t   = _ContainerTy;
+      // void for containers without an allocator
+      using allocator_t   = typename container_allocator<_ContainerTy>::type;
     };
 
 template<typename>